@@ -0,0 +1,22 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+namespace bench
+{
+    /**
+     * @brief Number of calls to the global operator new so far, from any thread.
+     */
+    uint64_t allocation_count();
+
+    /**
+     * @brief Reports the allocations made since start as an allocs/iter counter.
+     */
+    inline void report_allocations(benchmark::State& state, const uint64_t start)
+    {
+        state.counters["allocs/iter"] = benchmark::Counter(
+            static_cast<double>(allocation_count() - start),
+            benchmark::Counter::kAvgIterations);
+    }
+}
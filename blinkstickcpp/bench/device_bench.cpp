@@ -0,0 +1,185 @@
+#include "allocations.hpp"
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/simulator.hpp>
+#include <blinkstick/transport.hpp>
+#include <blinkstick/variant.hpp>
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace blinkstick;
+
+namespace
+{
+    // Accepts every report without looking at it, so only the library's own cost is measured
+    class null_transport : public transport
+    {
+    public:
+        bool send_feature_report(const uint8_t*, size_t) override
+        {
+            return true;
+        }
+
+        bool get_feature_report(uint8_t* data, size_t size) override
+        {
+            benchmark::DoNotOptimize(data);
+            benchmark::DoNotOptimize(size);
+            return true;
+        }
+    };
+
+    std::vector<colour> make_frame(const size_t count, const uint8_t seed)
+    {
+        std::vector<colour> frame(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            frame[i] = colour{ static_cast<uint8_t>(seed + i), static_cast<uint8_t>(i * 3), static_cast<uint8_t>(i * 7) };
+        }
+        return frame;
+    }
+
+    // The report packing in set_colours on its own
+    void pack_frame(benchmark::State& state)
+    {
+        const device target{ std::make_shared<null_transport>(), device_type::flex };
+        const auto frame = make_frame(static_cast<size_t>(state.range(0)), 0);
+        target.set_colours(0, frame.data(), frame.size());
+
+        const auto start = bench::allocation_count();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(target.set_colours(0, frame.data(), frame.size()));
+        }
+        bench::report_allocations(state, start);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(pack_frame)->Arg(8)->Arg(32)->Arg(64);
+
+    // The same frame through a model known at compile time
+    template<int LedCount>
+    void pack_fixed_frame(benchmark::State& state)
+    {
+        const flex_device<LedCount> target{ device{ std::make_shared<null_transport>(), device_type::flex } };
+        typename flex_device<LedCount>::frame frame;
+        const auto colours = make_frame(LedCount, 0);
+        std::copy(colours.begin(), colours.end(), frame.begin());
+        target.set_colours(frame);
+
+        const auto start = bench::allocation_count();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(target.set_colours(frame));
+        }
+        bench::report_allocations(state, start);
+        state.SetItemsProcessed(state.iterations() * LedCount);
+    }
+    BENCHMARK_TEMPLATE(pack_fixed_frame, 8);
+    BENCHMARK_TEMPLATE(pack_fixed_frame, 32);
+    BENCHMARK_TEMPLATE(pack_fixed_frame, 64);
+
+    // Delta encoding with a single LED changing per frame, which takes the indexed report path
+    void pack_frame_delta(benchmark::State& state)
+    {
+        device target{ std::make_shared<null_transport>(), device_type::flex };
+        target.set_delta_encoding(true);
+        auto frame = make_frame(static_cast<size_t>(state.range(0)), 0);
+        target.set_colours(0, frame.data(), frame.size());
+
+        const auto start = bench::allocation_count();
+        uint8_t tick = 0;
+        for (auto _ : state)
+        {
+            frame[tick % frame.size()].red = tick;
+            ++tick;
+            benchmark::DoNotOptimize(target.set_colours(0, frame.data(), frame.size()));
+        }
+        bench::report_allocations(state, start);
+    }
+    BENCHMARK(pack_frame_delta)->Arg(32)->Arg(64);
+
+    void get_colour_shadow(benchmark::State& state)
+    {
+        const device target{ std::make_shared<null_transport>(), device_type::flex };
+        const auto frame = make_frame(64, 0);
+        target.set_colours(0, frame.data(), frame.size());
+
+        int index = 0;
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(target.get_colour(0, index));
+            index = (index + 1) % 64;
+        }
+    }
+    BENCHMARK(get_colour_shadow);
+
+    // One bulk read and decode of a whole channel
+    void get_colours(benchmark::State& state)
+    {
+        const auto sim = std::make_shared<simulator>(device_type::flex, static_cast<uint8_t>(state.range(0)));
+        const device target{ sim, device_type::flex };
+        const auto frame = make_frame(static_cast<size_t>(state.range(0)), 0);
+        target.set_colours(0, frame.data(), frame.size());
+
+        const auto start = bench::allocation_count();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(target.get_colours(0));
+        }
+        bench::report_allocations(state, start);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(get_colours)->Arg(8)->Arg(32)->Arg(64);
+
+    // Frame submission through the simulator, which parses each report like a device would
+    void submit_frame(benchmark::State& state)
+    {
+        const auto sim = std::make_shared<simulator>(device_type::flex, static_cast<uint8_t>(state.range(0)));
+        const device target{ sim, device_type::flex };
+        const auto first = make_frame(static_cast<size_t>(state.range(0)), 0);
+        const auto second = make_frame(static_cast<size_t>(state.range(0)), 1);
+        target.set_colours(0, first.data(), first.size());
+
+        const auto start = bench::allocation_count();
+        bool flip = false;
+        for (auto _ : state)
+        {
+            const auto& frame = flip ? first : second;
+            flip = !flip;
+            benchmark::DoNotOptimize(target.set_colours(0, frame.data(), frame.size()));
+        }
+        bench::report_allocations(state, start);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.SetBytesProcessed(state.iterations() * (state.range(0) * 3 + 2));
+    }
+    BENCHMARK(submit_frame)->Arg(8)->Arg(32)->Arg(64);
+
+    // Strips longer than 64 LEDs, split across the channels of a Pro. The second argument is the
+    // simulated time per report in microseconds, roughly 1000 for a full speed USB control transfer.
+    void submit_long_strip(benchmark::State& state)
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+        const auto sim = std::make_shared<simulator>(device_type::pro, static_cast<uint8_t>(count));
+        sim->set_profile(report_profile{ std::chrono::microseconds(state.range(1)) });
+        const device target{ sim, device_type::pro };
+        const auto first = make_frame(count, 0);
+        const auto second = make_frame(count, 1);
+
+        const auto start = bench::allocation_count();
+        bool flip = false;
+        for (auto _ : state)
+        {
+            const auto& frame = flip ? first : second;
+            flip = !flip;
+            benchmark::DoNotOptimize(target.set_colours(0, frame.data(), frame.size()));
+        }
+        bench::report_allocations(state, start);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+        state.counters["frames/s"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    }
+    BENCHMARK(submit_long_strip)
+        ->ArgsProduct({ { 64, 128, 192 }, { 0, 1000 } })
+        ->UseRealTime();
+}
@@ -0,0 +1,170 @@
+#include "allocations.hpp"
+#include "packing.hpp"
+#include "protocol.hpp"
+
+#include <blinkstick/colour_space.hpp>
+#include <blinkstick/dither.hpp>
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using namespace blinkstick;
+
+namespace
+{
+    void build_control_message(benchmark::State& state)
+    {
+        uint8_t index = 0;
+        for (auto _ : state)
+        {
+            auto msg = protocol::build_control_message(index++, 1, 10, 20, 30);
+            benchmark::DoNotOptimize(msg);
+        }
+    }
+    BENCHMARK(build_control_message);
+
+    void determine_report_id(benchmark::State& state)
+    {
+        int count = 0;
+        for (auto _ : state)
+        {
+            auto report = protocol::determine_report_id(count);
+            benchmark::DoNotOptimize(report);
+            count = (count + 7) % (64 * 3);
+        }
+    }
+    BENCHMARK(determine_report_id);
+
+    void decode_colours(benchmark::State& state)
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+        std::vector<uint8_t> payload(count * 3);
+        for (size_t i = 0; i < payload.size(); ++i)
+        {
+            payload[i] = static_cast<uint8_t>(i);
+        }
+        std::vector<colour> colours(count);
+
+        const auto start = bench::allocation_count();
+        for (auto _ : state)
+        {
+            protocol::decode_colours(payload.data(), count, colours.data());
+            benchmark::DoNotOptimize(colours.data());
+            benchmark::ClobberMemory();
+        }
+        bench::report_allocations(state, start);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(decode_colours)->Arg(8)->Arg(32)->Arg(64);
+
+    void pack_grb(benchmark::State& state, const packing::kernel which, const uint8_t brightness)
+    {
+        if (!packing::supported(which))
+        {
+            state.SkipWithError("kernel not supported on this CPU");
+            return;
+        }
+        const auto count = static_cast<size_t>(state.range(0));
+        std::vector<colour> colours(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            colours[i] = colour{ static_cast<uint8_t>(i), static_cast<uint8_t>(i * 3), static_cast<uint8_t>(i * 7) };
+        }
+        std::vector<uint8_t> payload(count * 3);
+
+        for (auto _ : state)
+        {
+            packing::pack_grb(which, colours.data(), count, brightness, payload.data());
+            benchmark::DoNotOptimize(payload.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK_CAPTURE(pack_grb, scalar, packing::kernel::scalar, 255)->Arg(64)->Arg(1024);
+    BENCHMARK_CAPTURE(pack_grb, ssse3, packing::kernel::ssse3, 255)->Arg(64)->Arg(1024);
+    BENCHMARK_CAPTURE(pack_grb, avx2, packing::kernel::avx2, 255)->Arg(64)->Arg(1024);
+    BENCHMARK_CAPTURE(pack_grb, scalar_dimmed, packing::kernel::scalar, 128)->Arg(64)->Arg(1024);
+    BENCHMARK_CAPTURE(pack_grb, ssse3_dimmed, packing::kernel::ssse3, 128)->Arg(64)->Arg(1024);
+    BENCHMARK_CAPTURE(pack_grb, avx2_dimmed, packing::kernel::avx2, 128)->Arg(64)->Arg(1024);
+
+    void pack_grb_corrected(benchmark::State& state)
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+        const auto tables = make_correction(gamma_2_2, white_balance{ 255, 220, 200 });
+        std::vector<colour> colours(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            colours[i] = colour{ static_cast<uint8_t>(i), static_cast<uint8_t>(i * 3), static_cast<uint8_t>(i * 7) };
+        }
+        std::vector<uint8_t> payload(count * 3);
+
+        for (auto _ : state)
+        {
+            packing::pack_grb(colours.data(), count, tables, payload.data());
+            benchmark::DoNotOptimize(payload.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(pack_grb_corrected)->Arg(64)->Arg(1024);
+
+    void hsv_to_rgb(benchmark::State& state)
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+        std::vector<hsv> colours(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            colours[i] = hsv{ static_cast<uint8_t>(i), static_cast<uint8_t>(255 - i), 200 };
+        }
+        std::vector<colour> converted(count);
+
+        for (auto _ : state)
+        {
+            blinkstick::hsv_to_rgb(colours.data(), count, converted.data());
+            benchmark::DoNotOptimize(converted.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(hsv_to_rgb)->Arg(64)->Arg(4096);
+
+    void hsl_to_rgb(benchmark::State& state)
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+        std::vector<hsl> colours(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            colours[i] = hsl{ static_cast<uint8_t>(i), static_cast<uint8_t>(255 - i), 128 };
+        }
+        std::vector<colour> converted(count);
+
+        for (auto _ : state)
+        {
+            blinkstick::hsl_to_rgb(colours.data(), count, converted.data());
+            benchmark::DoNotOptimize(converted.data());
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(hsl_to_rgb)->Arg(64)->Arg(4096);
+
+    void quantise_dithered(benchmark::State& state)
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+        dithered_framebuffer framebuffer(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            framebuffer[i] = colour16{ static_cast<uint16_t>(i * 97), static_cast<uint16_t>(i * 31), static_cast<uint16_t>(i) };
+        }
+
+        const auto start = bench::allocation_count();
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(framebuffer.quantise().data());
+            benchmark::ClobberMemory();
+        }
+        bench::report_allocations(state, start);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(quantise_dithered)->Arg(64)->Arg(4096);
+}
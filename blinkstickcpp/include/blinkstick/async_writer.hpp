@@ -0,0 +1,98 @@
+#pragma once
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace blinkstick
+{
+    /**
+     * @brief Counters describing what happened to the frames given to an async_writer.
+     */
+    struct async_stats
+    {
+        uint64_t submitted = 0;
+        uint64_t sent = 0;
+        uint64_t failed = 0;
+
+        /**
+         * @brief Frames replaced by a newer frame for the same channel before they were sent.
+         */
+        uint64_t dropped = 0;
+    };
+
+    /**
+     * @brief Sends frames to a device from a dedicated I/O thread.
+     * @details submit() only copies the frame and returns, so a renderer never waits for the USB
+     * transfer. Each channel holds at most one pending frame: submitting while a frame is still
+     * waiting replaces it and counts the old one as dropped, so a slow stick always receives the
+     * newest frame rather than a growing backlog. The per-channel buffers are reused, so once they
+     * have grown to the frame size submitting does not allocate. While a writer exists it should
+     * be the only user of its device.
+     */
+    class BLINKSTICKCPP_EXPORT async_writer
+    {
+    public:
+        explicit async_writer(device target);
+
+        /**
+         * @brief Sends any pending frames and stops the I/O thread.
+         */
+        ~async_writer();
+
+        async_writer(const async_writer&) = delete;
+        async_writer& operator=(const async_writer&) = delete;
+
+        /**
+         * @brief Queues a frame for a channel without waiting for it to be sent.
+         * @return false if the writer is shutting down or the device has no such channel.
+         */
+        bool submit(int channel, const colour* colours, size_t count);
+
+        bool submit(int channel, const std::vector<colour>& colours);
+
+        /**
+         * @brief Blocks until every frame submitted so far has been sent or dropped.
+         */
+        void flush();
+
+        async_stats get_stats() const;
+
+    private:
+        struct slot
+        {
+            // Written by submit() under the lock
+            std::vector<colour> next;
+            bool pending = false;
+
+            // Owned by the I/O thread once swapped out of next
+            std::vector<colour> sending;
+            bool ready = false;
+        };
+
+        void run();
+
+        const device target;
+
+        mutable std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        std::vector<slot> slots;
+        size_t pending = 0;
+        bool busy = false;
+        bool stopping = false;
+
+        std::atomic<uint64_t> submitted{ 0 };
+        std::atomic<uint64_t> sent{ 0 };
+        std::atomic<uint64_t> failed{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+
+        std::thread worker;
+    };
+}
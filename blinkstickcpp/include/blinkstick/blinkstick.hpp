@@ -2,24 +2,39 @@
 
 #include <blinkstick/device.hpp>
 #include <blinkstick/export.hpp>
+#include <blinkstick/transport.hpp>
 #include <cstdint>
 #include <vector>
 
 namespace blinkstick
 {
 
+    /**
+     * @brief Lists the BlinkStick devices a backend can see without opening any of them.
+     * @param backend the I/O backend used to discover the devices.
+     */
+    std::vector<device_info> BLINKSTICKCPP_EXPORT enumerate(backend backend = backend::hidapi);
+
+    /**
+     * @brief Opens a device returned by enumerate().
+     * @return the device, which is not valid if it could not be opened.
+     */
+    device BLINKSTICKCPP_EXPORT open_device(const device_info& info, backend backend = backend::hidapi);
+
     /**
      * @brief Finds all BlinkStick devices
+     * @param backend the I/O backend used to discover and talk to the devices.
      * @return an vector of BlinkStick devices
      */
-    std::vector<device> BLINKSTICKCPP_EXPORT find_all();
+    std::vector<device> BLINKSTICKCPP_EXPORT find_all(backend backend = backend::hidapi);
 
     /**
      * @brief Find the first blinkstick device on the bus registered
      * with HID.
+     * @param backend the I/O backend used to discover and talk to the device.
      * @return a BlinkStick device.
      */
-    device BLINKSTICKCPP_EXPORT find();
+    device BLINKSTICKCPP_EXPORT find(backend backend = backend::hidapi);
 
     /**
     * @brief Function to be called when all devices are no longer being used
@@ -28,6 +43,7 @@ namespace blinkstick
 
     /**
      * @brief Turns on debug logging.
+     * @details Shorthand for set_log_level(log_level::debug); see log.hpp for sinks and levels.
      */
     void BLINKSTICKCPP_EXPORT enable_logging();
 }
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <blinkstick/export.hpp>
+#include <blinkstick/transport.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace blinkstick
+{
+    /**
+     * @brief Whether a captured report was sent to or read from the device.
+     */
+    enum class capture_direction : uint8_t
+    {
+        send,
+        get
+    };
+
+    /**
+     * @brief One feature report from a capture file.
+     */
+    struct capture_record
+    {
+        /**
+         * @brief Time since the capture started.
+         */
+        std::chrono::nanoseconds time{ 0 };
+        capture_direction direction = capture_direction::send;
+
+        /**
+         * @brief Whether the transport reported success.
+         */
+        bool ok = false;
+
+        /**
+         * @brief The report, starting with the report ID. Points into the mapped capture file and
+         * stays valid for the lifetime of the reader.
+         */
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    /**
+     * @brief Transport that forwards every report to another transport and appends it, with a
+     * timestamp, to a capture file.
+     * @details The file starts with a 16 byte header (the magic "BSTKCAP", a NUL, a version and a
+     * reserved word) followed by one record per report: a 64-bit nanosecond offset from the start
+     * of the capture, a 16-bit report size, the direction, a success flag and the report bytes.
+     * Integers are little-endian. Reads are recorded with the data the device returned. Safe to
+     * use from several threads.
+     */
+    class BLINKSTICKCPP_EXPORT recording_transport : public transport
+    {
+    public:
+        /**
+         * @brief Creates a capture file and starts recording the traffic of inner into it.
+         * @return the transport, or nullptr if the file could not be created.
+         */
+        static std::shared_ptr<recording_transport> open(const std::string& path, std::shared_ptr<transport> inner);
+
+        recording_transport(std::FILE* file, std::shared_ptr<transport> inner);
+
+        /**
+         * @brief Flushes and closes the capture file.
+         */
+        ~recording_transport() override;
+
+        recording_transport(const recording_transport&) = delete;
+        recording_transport& operator=(const recording_transport&) = delete;
+
+        bool send_feature_report(const uint8_t* data, size_t size) override;
+
+        bool get_feature_report(uint8_t* data, size_t size) override;
+
+        /**
+         * @brief Writes buffered records to the file, so they survive a crash.
+         */
+        bool flush();
+
+    private:
+        void record(capture_direction direction, bool ok, const uint8_t* data, size_t size);
+
+        std::FILE* file;
+        std::shared_ptr<transport> inner;
+        const std::chrono::steady_clock::time_point start;
+        std::mutex mutex;
+    };
+
+    /**
+     * @brief Reads a capture file through a read-only memory mapping.
+     * @details Pages are only brought in as records are read, so captures much larger than RAM
+     * can be replayed. A record cut short at the end of the file, e.g. by a crash while
+     * recording, ends the capture. Only available on POSIX systems; elsewhere is_open() is false.
+     */
+    class BLINKSTICKCPP_EXPORT capture_reader
+    {
+    public:
+        explicit capture_reader(const std::string& path);
+
+        ~capture_reader();
+
+        capture_reader(const capture_reader&) = delete;
+        capture_reader& operator=(const capture_reader&) = delete;
+
+        /**
+         * @brief Whether the file was mapped and has a valid header.
+         */
+        bool is_open() const;
+
+        /**
+         * @brief Reads the next record.
+         * @return false at the end of the capture.
+         */
+        bool next(capture_record& record);
+
+        /**
+         * @brief Goes back to the first record.
+         */
+        void rewind();
+
+    private:
+        const uint8_t* begin = nullptr;
+        size_t length = 0;
+        size_t position = 0;
+    };
+
+    struct replay_result
+    {
+        uint64_t sent = 0;
+        uint64_t failed = 0;
+
+        /**
+         * @brief Recorded reads, which are not replayed.
+         */
+        uint64_t skipped = 0;
+    };
+
+    /**
+     * @brief Sends the reports of a capture to a transport, from the reader's current position.
+     * @details Every recorded send is replayed, including those that failed when recorded, so the
+     * device sees the same sequence of reports.
+     * @param speed how much faster than recorded to replay, e.g. 2 for twice as fast. Zero or less
+     * sends the reports back to back without waiting.
+     */
+    replay_result BLINKSTICKCPP_EXPORT replay(capture_reader& reader, transport& target, double speed = 1.0);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace blinkstick
+{
+    /**
+     * @brief Hue, saturation and value in 8-bit fixed point. A hue of 256 would be a full turn.
+     */
+    struct hsv
+    {
+        uint8_t hue = 0;
+        uint8_t saturation = 0;
+        uint8_t value = 0;
+    };
+
+    /**
+     * @brief Hue, saturation and lightness in 8-bit fixed point. A hue of 256 would be a full turn.
+     */
+    struct hsl
+    {
+        uint8_t hue = 0;
+        uint8_t saturation = 0;
+        uint8_t lightness = 0;
+    };
+
+    /**
+     * @brief Converts an array of HSV colours to RGB.
+     * @details Integer only, and vectorised 16 colours at a time on CPUs with SSSE3. Every path
+     * gives exactly the same result. in and out may not overlap.
+     */
+    void BLINKSTICKCPP_EXPORT hsv_to_rgb(const hsv* in, size_t count, colour* out);
+
+    /**
+     * @brief Converts an array of HSL colours to RGB, like hsv_to_rgb().
+     */
+    void BLINKSTICKCPP_EXPORT hsl_to_rgb(const hsl* in, size_t count, colour* out);
+
+    colour BLINKSTICKCPP_EXPORT hsv_to_rgb(const hsv& in);
+
+    colour BLINKSTICKCPP_EXPORT hsl_to_rgb(const hsl& in);
+}
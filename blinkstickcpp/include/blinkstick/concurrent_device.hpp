@@ -0,0 +1,84 @@
+#pragma once
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace blinkstick
+{
+    /**
+     * @brief Thread-safe front end to a device.
+     * @details Any number of threads may call the setters at the same time. Each call only fills
+     * a preallocated cell of a lock-free ring; a single transport thread owns the device and
+     * executes the commands in the order they were queued, so producers never contend on a mutex
+     * and never allocate once the cells are warm. When every cell is in use the setters wait for
+     * the transport thread to catch up. While a concurrent_device exists it should be the only
+     * user of its device.
+     */
+    class BLINKSTICKCPP_EXPORT concurrent_device
+    {
+    public:
+        explicit concurrent_device(device target);
+
+        /**
+         * @brief Executes every queued command, then stops the transport thread.
+         */
+        ~concurrent_device();
+
+        concurrent_device(const concurrent_device&) = delete;
+        concurrent_device& operator=(const concurrent_device&) = delete;
+
+        /**
+         * @return false if the device is shutting down and the command was not queued.
+         */
+        bool set_colour(int channel, int index, uint8_t red, uint8_t green, uint8_t blue);
+
+        bool set_colours(int channel, std::vector<colour> colours);
+
+        bool set_mode(mode mode);
+
+        /**
+         * @brief Blocks until every command queued before the call has been executed.
+         */
+        void flush();
+
+        /**
+         * @brief Number of queued commands whose transfer failed.
+         */
+        uint64_t failed_commands() const;
+
+        const device& get_device() const;
+
+    private:
+        struct command;
+        struct queue;
+
+        template<typename Fill>
+        bool enqueue(Fill&& fill);
+        void run();
+        bool execute(const command& command);
+
+        const device target;
+        std::unique_ptr<queue> commands;
+
+        std::atomic<uint64_t> queued{ 0 };
+        std::atomic<uint64_t> executed{ 0 };
+        std::atomic<uint64_t> failed{ 0 };
+        std::atomic<bool> sleeping{ false };
+        std::atomic<int> flushing{ 0 };
+        std::atomic<bool> stopping{ false };
+        std::atomic<int> entering{ 0 };
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable drained;
+
+        std::thread worker;
+    };
+}
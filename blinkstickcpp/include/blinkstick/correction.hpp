@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace blinkstick
+{
+    /**
+     * @brief A 256 entry lookup table from a channel value to the value sent to the device.
+     */
+    using channel_table = std::array<uint8_t, 256>;
+
+    /**
+     * @brief Per-channel maximum output, to even out LEDs whose red, green and blue differ in
+     * strength. 255 leaves a channel unchanged.
+     */
+    struct white_balance
+    {
+        uint8_t red = 255;
+        uint8_t green = 255;
+        uint8_t blue = 255;
+    };
+
+    /**
+     * @brief Lookup tables for each channel, applied while a report is built.
+     */
+    struct colour_correction
+    {
+        channel_table red;
+        channel_table green;
+        channel_table blue;
+    };
+
+    namespace detail
+    {
+        inline constexpr double LN2 = 0.69314718055994530942;
+
+        // std::log and std::exp are not constexpr, so compile-time tables bring their own
+
+        constexpr double log(double x)
+        {
+            // x = m * 2^e with m in [0.5, 1), where the atanh series converges quickly
+            int e = 0;
+            while (x >= 1.0)
+            {
+                x *= 0.5;
+                ++e;
+            }
+            while (x < 0.5)
+            {
+                x *= 2.0;
+                --e;
+            }
+            const double z = (x - 1.0) / (x + 1.0);
+            const double z2 = z * z;
+            double term = z;
+            double sum = 0.0;
+            for (int k = 1; k < 40; k += 2)
+            {
+                sum += term / k;
+                term *= z2;
+            }
+            return 2.0 * sum + e * LN2;
+        }
+
+        constexpr double exp(const double y)
+        {
+            // y = k * ln 2 + r with |r| <= ln 2
+            const int k = static_cast<int>(y / LN2);
+            const double r = y - k * LN2;
+            double term = 1.0;
+            double sum = 1.0;
+            for (int n = 1; n < 30; ++n)
+            {
+                term *= r / n;
+                sum += term;
+            }
+            for (int i = 0; i < k; ++i)
+            {
+                sum *= 2.0;
+            }
+            for (int i = 0; i > k; --i)
+            {
+                sum *= 0.5;
+            }
+            return sum;
+        }
+
+        constexpr uint8_t to_channel(const double value)
+        {
+            return value <= 0.0 ? 0 : value >= 255.0 ? 255 : static_cast<uint8_t>(value + 0.5);
+        }
+    }
+
+    /**
+     * @brief Builds a table mapping v to 255 * (v / 255)^gamma.
+     * @details Usable in constant expressions, e.g. constexpr auto table = make_gamma_table(2.2),
+     * so correction costs nothing at runtime beyond the lookup.
+     */
+    constexpr channel_table make_gamma_table(const double gamma)
+    {
+        channel_table table{};
+        for (int i = 1; i < 256; ++i)
+        {
+            table[i] = detail::to_channel(255.0 * detail::exp(gamma * detail::log(i / 255.0)));
+        }
+        return table;
+    }
+
+    /**
+     * @brief A table that leaves values unchanged.
+     */
+    constexpr channel_table make_identity_table()
+    {
+        channel_table table{};
+        for (int i = 0; i < 256; ++i)
+        {
+            table[i] = static_cast<uint8_t>(i);
+        }
+        return table;
+    }
+
+    /**
+     * @brief The gamma usually quoted for WS2812 style LEDs.
+     * @details inline, so every translation unit shares one table instead of its own copy.
+     */
+    inline constexpr channel_table gamma_2_2 = make_gamma_table(2.2);
+
+    /**
+     * @brief Merges a gamma table and a white balance into one table per channel.
+     */
+    constexpr colour_correction make_correction(const channel_table& gamma, const white_balance& balance = {})
+    {
+        colour_correction correction{};
+        for (int i = 0; i < 256; ++i)
+        {
+            correction.red[i] = static_cast<uint8_t>((gamma[i] * (balance.red + 1)) >> 8);
+            correction.green[i] = static_cast<uint8_t>((gamma[i] * (balance.green + 1)) >> 8);
+            correction.blue[i] = static_cast<uint8_t>((gamma[i] * (balance.blue + 1)) >> 8);
+        }
+        return correction;
+    }
+}
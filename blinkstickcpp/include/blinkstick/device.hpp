@@ -1,9 +1,13 @@
 #pragma once
 
+#include <blinkstick/correction.hpp>
 #include <blinkstick/export.hpp>
+#include <blinkstick/stats.hpp>
+#include <blinkstick/transport.hpp>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
-#include <optional>
+#include <string>
 #include <vector>
 
 struct hid_device_;
@@ -44,12 +48,55 @@ namespace blinkstick
         uint8_t blue = 0;
     };
 
+    /**
+     * @brief What is known about a device from enumeration, before it is opened.
+     */
+    struct device_info
+    {
+        /**
+         * @brief Backend specific path used to open the device.
+         */
+        std::string path;
+        std::string serial;
+        device_type type = device_type::unknown;
+    };
+
+    constexpr bool operator==(const colour& lhs, const colour& rhs)
+    {
+        return lhs.red == rhs.red && lhs.green == rhs.green && lhs.blue == rhs.blue;
+    }
+
+    constexpr bool operator!=(const colour& lhs, const colour& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * @brief A single BlinkStick.
+     * @details Copies of a device share its transport and cached state, so a device and all of
+     * its copies must be used from one thread at a time.
+     */
     class BLINKSTICKCPP_EXPORT device
     {
     public:
+        device(
+            std::shared_ptr<transport> io,
+            device_type type);
+
+        /**
+         * @brief Creates a device that talks to an already opened hidapi handle.
+         */
         device(
             std::shared_ptr<hid_device> handle,
             device_type type);
+
+        /**
+         * @brief Creates a device without a transport, for which is_valid() is false.
+         * @details Keeps device{ nullptr, type } unambiguous between the two constructors above.
+         */
+        device(
+            std::nullptr_t,
+            device_type type);
         /**
          * @brief Sets the LED at the given index and channel to the specified color for the
          * provided device.
@@ -72,17 +119,108 @@ namespace blinkstick
             uint8_t green,
             uint8_t blue) const;
 
+        /**
+         * @brief Sets the LEDs of a channel, starting from the first one. LEDs without a colour are turned off.
+         * @details With delta encoding enabled only the LEDs that differ from the previous frame
+         * are sent, as individual reports, whenever that costs fewer bytes than a full report.
+         */
         bool set_colours(
             int channel,
             const std::vector<colour>& colours) const;
 
         /**
-         * @brief Reads the color from the blinkstick at a given index.
+         * @brief Sets the LEDs of a channel from a contiguous array of colours.
+         * @details Builds the report in a buffer owned by the device, so once the first frame has
+         * been sent no further frames allocate. A report carries at most 64 LEDs, so when the LED
+         * count is higher the frame is split into 64 LED segments sent back to back to this and
+         * the following channels, e.g. 192 LEDs on channels 0, 1 and 2 of a Pro.
+         */
+        bool set_colours(
+            int channel,
+            const colour* colours,
+            size_t count) const;
+
+        /**
+         * @brief Sends one bulk colour report built in a buffer supplied by the caller.
+         * @details For callers that know the model at compile time, see fixed_device: no LED
+         * count lookup, report selection or delta encoding happens. Brightness and colour
+         * correction still apply.
+         * @param report_id the bulk colour report (6 - 10) matching report_size.
+         * @param colours the LEDs to send; LEDs the report has room for beyond count are turned off.
+         * @param report scratch space of report_size bytes.
+         */
+        bool send_colours(
+            uint8_t report_id,
+            int channel,
+            const colour* colours,
+            size_t count,
+            uint8_t* report,
+            size_t report_size) const;
+
+        /**
+         * @brief Compares each frame with the host-side copy of the previous one so only what changed is sent.
+         * @details Assumes nothing else writes to the device, otherwise the copy goes stale.
+         * Applies to every copy of this device. Disabled by default.
+         */
+        void set_delta_encoding(bool enabled);
+
+        /**
+         * @brief Scales every colour sent to the device, where 255 (the default) is unchanged.
+         * @details Applied while the report is built, so get_colour() still returns the colours
+         * as they were given. Changing it discards the host-side copy of the last frames, so the
+         * next frame is sent in full. Applies to every copy of this device.
+         */
+        void set_brightness(uint8_t brightness);
+
+        uint8_t get_brightness() const;
+
+        /**
+         * @brief Maps every colour sent to the device through per-channel lookup tables, e.g.
+         * make_correction(gamma_2_2, balance).
+         * @details The brightness is folded into the tables, so each LED costs three lookups
+         * while the report is built. Like the brightness, it does not change what get_colour()
+         * returns. Applies to every copy of this device.
+         */
+        void set_colour_correction(const colour_correction& correction);
+
+        void clear_colour_correction();
+
+        /**
+         * @brief Reads the color from the blinkstick at a given index on the first channel.
          * @param index the index of the LED to read from.
          * @return pointer to a color struct containing the read color.
          */
         colour get_colour(int index) const;
 
+        /**
+         * @brief Returns the colour last written to an LED.
+         * @details Served from a host-side copy of the last frame written to the channel, so no
+         * USB transfer is needed. Falls back to reading the device when that copy is not
+         * available, e.g. before the first frame or after a failed write. Only channel 0 can be
+         * read back, so LEDs on other channels without a copy come back black. On a strip longer
+         * than 64 LEDs the index runs along the whole strip, like set_colours().
+         */
+        colour get_colour(int channel, int index) const;
+
+        /**
+         * @brief Reads all LEDs back from the device in a single transfer and replaces the
+         * host-side copy of the channel with them.
+         * @details Use this when the hardware, rather than what was last written, is the truth
+         * wanted. The colour reports have no channel selector, so only channel 0 can be read;
+         * any other channel fails and leaves its copy untouched.
+         */
+        bool sync_colours(int channel) const;
+
+        /**
+         * @brief Reads every LED of a channel from the device.
+         * @details Costs a single report transfer regardless of the LED count, and refreshes the
+         * host-side copy like sync_colours(). Like sync_colours(), only channel 0 can be read. A
+         * strip longer than 64 LEDs is written in 64 LED segments on consecutive channels, and
+         * only the first segment can be read back, so the result then holds its 64 LEDs.
+         * @return the colours of the device's LEDs, or an empty vector if the read failed.
+         */
+        std::vector<colour> get_colours(int channel) const;
+
         /**
          * @brief Set the mode of the blinkstick.
          * @details Possible modes are "normal" (non-inverse LED control),
@@ -94,6 +232,8 @@ namespace blinkstick
 
         /**
          * @brief Read the mode currently set on the blinkstick.
+         * @details Only queries the device until the mode is known, either from a previous read or
+         * from set_mode() on this device or any copy of it.
          * @return the current mode.
          */
         mode get_mode() const;
@@ -109,7 +249,7 @@ namespace blinkstick
         /**
         * @brief Gets the number of leds on the device
         * @detail This will query the device on the first call, then cache the result so subsequent
-        * calls not do query the device
+        * calls not do query the device. The cache is shared with every copy of this device.
         */
         int get_led_count() const;
 
@@ -117,6 +257,22 @@ namespace blinkstick
 
         device_type get_type() const;
 
+        /**
+         * @brief Identifies the physical device: the same for a device and every copy of it.
+         */
+        const void* get_id() const;
+
+        /**
+         * @brief Copies the transfer counters and latency histograms of the device.
+         * @details Counters are kept per physical device, so every copy reports the same numbers.
+         */
+        stats_snapshot get_stats() const;
+
+        /**
+         * @brief Sets how many times a failed transfer is retried before giving up. Defaults to 0.
+         */
+        void set_retry_limit(int retries);
+
         /**
         * @brief
         * @return Whether or not the device is valid
@@ -124,8 +280,18 @@ namespace blinkstick
         bool is_valid() const;
 
     private:
-        std::shared_ptr<hid_device> handle;
+        struct state;
+
+        bool set_segment(int channel, const colour* colours, size_t count, uint8_t report_id, int max_leds) const;
+        bool send_report(const uint8_t* data, size_t size) const;
+        bool get_report(uint8_t* data, size_t size) const;
+        colour read_colour(int index) const;
+
+        std::shared_ptr<transport> io;
         device_type type;
-        mutable std::optional<int> led_count;
+
+        // Cached LED count and mode, shadow frames, scratch buffers and stats. Shared by every copy of
+        // the device so the cache is filled once per physical device rather than once per copy.
+        std::shared_ptr<state> shared;
     };
 }
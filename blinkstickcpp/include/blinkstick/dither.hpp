@@ -0,0 +1,76 @@
+#pragma once
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace blinkstick
+{
+    /**
+     * @brief A colour with 16 bits per channel, where 65535 is full brightness.
+     */
+    struct colour16
+    {
+        uint16_t red = 0;
+        uint16_t green = 0;
+        uint16_t blue = 0;
+    };
+
+    /**
+     * @brief The 16-bit colour that quantises back to exactly the given colour on every frame.
+     * @details Each channel moves to the high byte and leaves the low byte, which dithering carries
+     * over between frames, at zero. Scaling by 257 instead would fill the low byte, so the LED would
+     * flicker between two neighbouring values.
+     */
+    constexpr colour16 widen(const colour& value)
+    {
+        return colour16{
+            static_cast<uint16_t>(value.red << 8),
+            static_cast<uint16_t>(value.green << 8),
+            static_cast<uint16_t>(value.blue << 8) };
+    }
+
+    /**
+     * @brief LEDs held at 16 bits per channel and quantised to 8 bits with temporal dithering.
+     * @details Each quantise() carries the part of every channel that was cut off over to the
+     * next frame, so over a few frames an LED averages out to its 16-bit value. This hides the
+     * stepping of slow fades at low brightness, provided frames keep being sent. The carried
+     * error starts staggered between LEDs so they do not all flicker on the same frame.
+     * Quantising is vectorised with SSE2, or AVX2 where available.
+     */
+    class BLINKSTICKCPP_EXPORT dithered_framebuffer
+    {
+    public:
+        explicit dithered_framebuffer(size_t count);
+
+        size_t size() const;
+
+        colour16* data();
+
+        const colour16* data() const;
+
+        colour16& operator[](size_t index);
+
+        const colour16& operator[](size_t index) const;
+
+        void fill(const colour16& value);
+
+        /**
+         * @brief Produces the next 8-bit frame and updates the carried error.
+         * @return the frame, valid until the next call.
+         */
+        const std::vector<colour>& quantise();
+
+        /**
+         * @brief Quantises and sends the next frame to a device channel.
+         */
+        bool send(const device& target, int channel);
+
+    private:
+        std::vector<colour16> pixels;
+        std::vector<uint16_t> error;
+        std::vector<colour> output;
+    };
+}
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <blinkstick/colour_space.hpp>
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace blinkstick
+{
+    /**
+     * @brief An animation that draws a frame for a point in time.
+     * @details Effects are evaluated against the time since they were added to an engine, so
+     * everything driven by the same engine stays in step. Rendering is called from the engine's
+     * thread only, but an effect instance must not be added to more than one engine at once.
+     */
+    class BLINKSTICKCPP_EXPORT effect
+    {
+    public:
+        virtual ~effect() = default;
+
+        /**
+         * @brief Draws the frame for the given time.
+         * @param elapsed time since the effect started.
+         * @param frame the LEDs to draw into, holding the previous frame.
+         * @param count the number of LEDs in frame.
+         */
+        virtual void render(std::chrono::nanoseconds elapsed, colour* frame, size_t count) = 0;
+    };
+
+    /**
+     * @brief Every LED the same colour.
+     */
+    class BLINKSTICKCPP_EXPORT solid_effect : public effect
+    {
+    public:
+        explicit solid_effect(colour value);
+
+        void render(std::chrono::nanoseconds elapsed, colour* frame, size_t count) override;
+
+    private:
+        const colour value;
+    };
+
+    /**
+     * @brief Every LED breathing between off and a colour along a sine wave.
+     */
+    class BLINKSTICKCPP_EXPORT pulse_effect : public effect
+    {
+    public:
+        pulse_effect(colour value, std::chrono::nanoseconds period);
+
+        void render(std::chrono::nanoseconds elapsed, colour* frame, size_t count) override;
+
+    private:
+        const colour value;
+        const std::chrono::nanoseconds period;
+    };
+
+    /**
+     * @brief A hue wheel spread along the LEDs and rotating over time.
+     */
+    class BLINKSTICKCPP_EXPORT rainbow_effect : public effect
+    {
+    public:
+        /**
+         * @param period the time for one full turn of the wheel.
+         * @param spread how many times the wheel repeats along the LEDs, in 1/256ths.
+         */
+        explicit rainbow_effect(std::chrono::nanoseconds period, uint16_t spread = 256);
+
+        void render(std::chrono::nanoseconds elapsed, colour* frame, size_t count) override;
+
+    private:
+        const std::chrono::nanoseconds period;
+        const uint16_t spread;
+        std::vector<hsv> hues;
+    };
+
+    /**
+     * @brief A lit segment with a fading tail running along the LEDs.
+     */
+    class BLINKSTICKCPP_EXPORT chase_effect : public effect
+    {
+    public:
+        /**
+         * @param period the time the head takes to run the length of the LEDs.
+         * @param length the number of LEDs in the segment, including the tail.
+         */
+        chase_effect(colour value, colour background, std::chrono::nanoseconds period, size_t length);
+
+        void render(std::chrono::nanoseconds elapsed, colour* frame, size_t count) override;
+
+    private:
+        const colour value;
+        const colour background;
+        const std::chrono::nanoseconds period;
+        const size_t length;
+    };
+
+    /**
+     * @brief LEDs lighting up at random and fading out.
+     */
+    class BLINKSTICKCPP_EXPORT twinkle_effect : public effect
+    {
+    public:
+        /**
+         * @param density the chance, in 1/65536ths, that an LED sparks in each millisecond.
+         * @param decay the time a spark takes to fade out.
+         */
+        twinkle_effect(colour value, uint16_t density, std::chrono::nanoseconds decay, uint32_t seed = 1);
+
+        void render(std::chrono::nanoseconds elapsed, colour* frame, size_t count) override;
+
+    private:
+        uint32_t next_random();
+
+        const colour value;
+        const uint16_t density;
+        const std::chrono::nanoseconds decay;
+        uint32_t state;
+        std::chrono::nanoseconds last{ 0 };
+        std::vector<uint16_t> levels;
+    };
+
+    /**
+     * @brief Every LED blending from one colour to another, then holding the second.
+     */
+    class BLINKSTICKCPP_EXPORT fade_effect : public effect
+    {
+    public:
+        fade_effect(colour from, colour to, std::chrono::nanoseconds duration);
+
+        void render(std::chrono::nanoseconds elapsed, colour* frame, size_t count) override;
+
+    private:
+        const colour from;
+        const colour to;
+        const std::chrono::nanoseconds duration;
+    };
+
+    /**
+     * @brief Monotonic clock ticking at a fixed frame rate.
+     * @details Ticks are laid out from the first one rather than from when the caller woke up, so
+     * a late frame does not push every later frame back. Ticks that have already passed are
+     * skipped and counted.
+     */
+    class BLINKSTICKCPP_EXPORT frame_clock
+    {
+    public:
+        explicit frame_clock(double fps);
+
+        /**
+         * @brief Sleeps until the next tick.
+         * @return the time of the tick.
+         */
+        std::chrono::steady_clock::time_point wait();
+
+        std::chrono::nanoseconds interval() const;
+
+        /**
+         * @brief Number of ticks skipped because the caller was too late for them.
+         */
+        uint64_t missed() const;
+
+    private:
+        const std::chrono::nanoseconds period;
+        std::chrono::steady_clock::time_point next;
+        uint64_t skipped = 0;
+    };
+
+    struct effects_stats
+    {
+        uint64_t frames = 0;
+
+        /**
+         * @brief Framebuffers sent to their device.
+         */
+        uint64_t submitted = 0;
+
+        /**
+         * @brief Framebuffers not sent because they did not change since the last frame.
+         */
+        uint64_t unchanged = 0;
+        uint64_t failed = 0;
+
+        /**
+         * @brief Ticks skipped because rendering and sending a frame took longer than the interval.
+         */
+        uint64_t missed = 0;
+    };
+
+    /**
+     * @brief Renders effects into per-device framebuffers and sends them on a shared frame clock.
+     * @details Every frame, each effect draws into its framebuffer for the same instant, then
+     * framebuffers that changed are sent with set_colours(). Rendering and sending happen on one
+     * thread, either the engine's own (start()) or the caller's (render()). While an engine drives
+     * a device it should be the only user of that device's channel.
+     */
+    class BLINKSTICKCPP_EXPORT effects_engine
+    {
+    public:
+        using handle = uint64_t;
+
+        effects_engine() = default;
+
+        /**
+         * @brief Stops the render thread if it is running.
+         */
+        ~effects_engine();
+
+        effects_engine(const effects_engine&) = delete;
+        effects_engine& operator=(const effects_engine&) = delete;
+
+        /**
+         * @brief Starts running an effect on a device channel, from the next frame.
+         * @return a handle to remove the effect with.
+         */
+        handle add(device target, int channel, size_t led_count, std::shared_ptr<effect> animation);
+
+        /**
+         * @brief Stops an effect. The LEDs keep the last frame sent.
+         * @details Does not wait for a frame in progress, which may still send the effect's
+         * framebuffer once.
+         * @return false if there is no such effect.
+         */
+        bool remove(handle id);
+
+        size_t size() const;
+
+        /**
+         * @brief Renders and sends one frame for the given instant.
+         */
+        void render(std::chrono::steady_clock::time_point now);
+
+        /**
+         * @brief Renders frames on a background thread at the given rate until stop().
+         */
+        void start(double fps);
+
+        void stop();
+
+        effects_stats get_stats() const;
+
+    private:
+        // Only touched by the rendering thread once added
+        struct slot
+        {
+            handle id;
+            device target;
+            int channel;
+            std::shared_ptr<effect> animation;
+            std::chrono::steady_clock::time_point started;
+            bool fresh;
+            std::vector<colour> frame;
+            std::vector<colour> sent;
+        };
+
+        void run(double fps);
+
+        // Guards slots and next_id
+        mutable std::mutex mutex;
+        std::vector<std::shared_ptr<slot>> slots;
+        handle next_id = 1;
+
+        // Held for a whole frame, so frames never overlap. active is the frame's copy of slots
+        std::mutex render_mutex;
+        std::vector<std::shared_ptr<slot>> active;
+
+        std::atomic<bool> stopping{ false };
+        std::thread worker;
+
+        std::atomic<uint64_t> frames{ 0 };
+        std::atomic<uint64_t> submitted{ 0 };
+        std::atomic<uint64_t> unchanged{ 0 };
+        std::atomic<uint64_t> failed{ 0 };
+        std::atomic<uint64_t> missed{ 0 };
+    };
+}
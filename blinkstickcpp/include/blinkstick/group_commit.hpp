@@ -0,0 +1,100 @@
+#pragma once
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace blinkstick
+{
+    /**
+     * @brief A frame destined for one channel of one device.
+     */
+    struct device_frame
+    {
+        device target;
+        int channel = 0;
+        std::vector<colour> colours;
+    };
+
+    enum class frame_status
+    {
+        sent,
+        failed,
+
+        /**
+         * @brief The deadline passed before the frame was sent. It may still be in flight.
+         */
+        timed_out,
+
+        /**
+         * @brief The device was still busy with a frame from an earlier commit that timed out, so
+         * this frame was not sent.
+         */
+        dropped
+    };
+
+    struct commit_result
+    {
+        /**
+         * @brief The outcome of each frame, in the order the frames were given.
+         */
+        std::vector<frame_status> status;
+        size_t sent = 0;
+        size_t failed = 0;
+        size_t timed_out = 0;
+        size_t dropped = 0;
+    };
+
+    /**
+     * @brief Sends one frame to each of many devices in parallel over a pool of worker threads.
+     * @details Instead of paying for every device's transfer one after the other, the reports are
+     * spread across the pool so a commit takes roughly as long as the slowest device. Every frame
+     * in a commit must target a different device, and those devices must not be used elsewhere
+     * while the commit is running. A frame whose device is still busy with a timed out frame from
+     * an earlier commit is dropped rather than sent alongside it.
+     */
+    class BLINKSTICKCPP_EXPORT group_committer
+    {
+    public:
+        /**
+         * @param workers the number of worker threads, at least one.
+         */
+        explicit group_committer(size_t workers = std::thread::hardware_concurrency());
+
+        ~group_committer();
+
+        group_committer(const group_committer&) = delete;
+        group_committer& operator=(const group_committer&) = delete;
+
+        /**
+         * @brief Sends every frame and waits until all are done or the deadline passes.
+         * @details Frames that have not started by the deadline are skipped; frames already in
+         * flight finish in the background and are reported as timed out.
+         */
+        commit_result commit(
+            std::vector<device_frame> frames,
+            std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    private:
+        struct batch;
+
+        void run();
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<std::shared_ptr<batch>> batches;
+
+        // Devices a worker is currently sending to, by device::get_id()
+        std::set<const void*> in_flight;
+        bool stopping = false;
+        std::vector<std::thread> workers;
+    };
+}
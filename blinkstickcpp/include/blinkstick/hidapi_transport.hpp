@@ -0,0 +1,27 @@
+#pragma once
+
+#include <blinkstick/export.hpp>
+#include <blinkstick/transport.hpp>
+#include <memory>
+
+struct hid_device_;
+using hid_device = hid_device_;
+
+namespace blinkstick
+{
+    /**
+     * @brief Transport that talks to the device through hidapi.
+     */
+    class BLINKSTICKCPP_EXPORT hidapi_transport : public transport
+    {
+    public:
+        explicit hidapi_transport(std::shared_ptr<hid_device> handle);
+
+        bool send_feature_report(const uint8_t* data, size_t size) override;
+
+        bool get_feature_report(uint8_t* data, size_t size) override;
+
+    private:
+        std::shared_ptr<hid_device> handle;
+    };
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <blinkstick/export.hpp>
+#include <blinkstick/transport.hpp>
+#include <memory>
+#include <string>
+
+namespace blinkstick
+{
+    /**
+     * @brief Transport that issues feature-report ioctls directly on a Linux /dev/hidrawN node.
+     * @details Skips hidapi entirely, so each report costs a single ioctl. Only functional on Linux;
+     * elsewhere every call fails.
+     */
+    class BLINKSTICKCPP_EXPORT hidraw_transport : public transport
+    {
+    public:
+        /**
+         * @brief Signature of the function used to issue ioctls, replaceable to test without a kernel node.
+         */
+        using ioctl_function = int (*)(int fd, unsigned long request, void* arg);
+
+        /**
+         * @brief Takes ownership of an already opened file descriptor.
+         * @param fd the hidraw file descriptor, closed when the transport is destroyed.
+         * @param control the function used to issue ioctls on fd.
+         */
+        explicit hidraw_transport(int fd, ioctl_function control = nullptr);
+
+        ~hidraw_transport() override;
+
+        hidraw_transport(const hidraw_transport&) = delete;
+        hidraw_transport& operator=(const hidraw_transport&) = delete;
+
+        /**
+         * @brief Opens a hidraw node for reading and writing.
+         * @param path the device node, e.g. /dev/hidraw0.
+         * @return the transport, or nullptr if the node could not be opened.
+         */
+        static std::shared_ptr<hidraw_transport> open(const std::string& path);
+
+        bool send_feature_report(const uint8_t* data, size_t size) override;
+
+        bool get_feature_report(uint8_t* data, size_t size) override;
+
+    private:
+        int fd;
+        ioctl_function control;
+    };
+}
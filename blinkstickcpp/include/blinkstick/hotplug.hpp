@@ -0,0 +1,153 @@
+#pragma once
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <blinkstick/registry.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace blinkstick
+{
+    /**
+     * @brief A kernel device event, as broadcast over the uevent netlink socket.
+     */
+    struct uevent
+    {
+        std::string action;
+        std::string devpath;
+        std::string subsystem;
+
+        /**
+         * @brief The node name, without any /dev/ prefix.
+         */
+        std::string devname;
+    };
+
+    /**
+     * @brief Supplies device events to a hotplug_monitor.
+     * @details Implement this to drive a monitor from something other than the kernel, e.g. a
+     * list of canned events in a test.
+     */
+    class BLINKSTICKCPP_EXPORT uevent_source
+    {
+    public:
+        virtual ~uevent_source() = default;
+
+        /**
+         * @brief Waits up to timeout for the next event.
+         * @return the event, or nothing if none arrived in time.
+         */
+        virtual std::optional<uevent> receive(std::chrono::milliseconds timeout) = 0;
+    };
+
+    /**
+     * @brief Receives device events from a NETLINK_KOBJECT_UEVENT socket. Linux only.
+     */
+    class BLINKSTICKCPP_EXPORT netlink_uevent_source : public uevent_source
+    {
+    public:
+        enum class group
+        {
+            /**
+             * @brief Raw kernel events, sent before udev has created the device node.
+             */
+            kernel = 1,
+
+            /**
+             * @brief Events re-broadcast by udev once the device node is ready.
+             */
+            udev = 2
+        };
+
+        explicit netlink_uevent_source(group group = group::udev);
+
+        ~netlink_uevent_source() override;
+
+        netlink_uevent_source(const netlink_uevent_source&) = delete;
+        netlink_uevent_source& operator=(const netlink_uevent_source&) = delete;
+
+        /**
+         * @brief Whether the socket could be opened.
+         */
+        bool is_valid() const;
+
+        std::optional<uevent> receive(std::chrono::milliseconds timeout) override;
+
+        /**
+         * @brief Decodes a single netlink message in either the kernel or the udev format.
+         */
+        static std::optional<uevent> parse(const char* data, size_t size);
+
+    private:
+        int fd;
+    };
+
+    struct hotplug_event
+    {
+        enum class kind
+        {
+            added,
+            removed
+        };
+
+        kind type;
+        device_info info;
+    };
+
+    /**
+     * @brief Keeps a registry up to date as BlinkSticks are plugged and unplugged.
+     * @details Listens for hidraw events on a background thread and only touches the affected
+     * device: with the hidraw backend the registry entry is added or removed directly, other
+     * backends re-enumerate once per event. Subscribers are called on the monitor thread after the
+     * registry has been updated, without holding any lock, so a callback may subscribe or
+     * unsubscribe. A callback unsubscribed while an event is being delivered may still receive
+     * that event.
+     */
+    class BLINKSTICKCPP_EXPORT hotplug_monitor
+    {
+    public:
+        using callback = std::function<void(const hotplug_event&)>;
+
+        hotplug_monitor(registry& devices, std::unique_ptr<uevent_source> source);
+
+        ~hotplug_monitor();
+
+        hotplug_monitor(const hotplug_monitor&) = delete;
+        hotplug_monitor& operator=(const hotplug_monitor&) = delete;
+
+        /**
+         * @return an id for unsubscribe().
+         */
+        int subscribe(callback callback);
+
+        void unsubscribe(int id);
+
+        /**
+         * @brief Applies a single event to the registry. Called by the monitor thread for every
+         * event received from the source.
+         */
+        void handle(const uevent& event);
+
+    private:
+        void run();
+        void notify(const hotplug_event& event);
+
+        registry& devices;
+        std::unique_ptr<uevent_source> source;
+
+        std::mutex subscribers_mutex;
+        std::map<int, callback> subscribers;
+        int next_id = 0;
+
+        std::atomic<bool> stopping{ false };
+        std::thread worker;
+    };
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <blinkstick/export.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+namespace blinkstick
+{
+    enum class log_level
+    {
+        trace,
+        debug,
+        info,
+        warning,
+        error,
+        off
+    };
+
+    /**
+     * @brief A key and value attached to a log record. Text values longer than the inline
+     * buffer are truncated.
+     */
+    struct BLINKSTICKCPP_EXPORT log_field
+    {
+        static constexpr size_t max_text = 47;
+
+        enum class kind
+        {
+            integer,
+            text
+        };
+
+        log_field() = default;
+
+        template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+        log_field(const char* key, const T value) :
+            key(key),
+            type(kind::integer),
+            integer(static_cast<int64_t>(value))
+        {
+        }
+
+        log_field(const char* key, const char* value);
+
+        log_field(const char* key, const std::string& value);
+
+        /**
+         * @brief Must point to a string that outlives the logger, normally a literal.
+         */
+        const char* key = nullptr;
+        kind type = kind::integer;
+        int64_t integer = 0;
+        std::array<char, max_text + 1> text{};
+    };
+
+    /**
+     * @brief A fixed-size, binary log entry. Nothing is formatted until it reaches the sink.
+     */
+    struct log_record
+    {
+        static constexpr size_t max_fields = 4;
+
+        log_level level = log_level::off;
+        std::chrono::system_clock::time_point time;
+
+        /**
+         * @brief Must point to a string that outlives the logger, normally a literal.
+         */
+        const char* message = nullptr;
+        size_t field_count = 0;
+        std::array<log_field, max_fields> fields;
+    };
+
+    namespace detail
+    {
+        BLINKSTICKCPP_EXPORT extern std::atomic<int> log_threshold;
+
+        void BLINKSTICKCPP_EXPORT log_write(log_record& record);
+    }
+
+    /**
+     * @brief Whether records of the given level are currently kept. A single relaxed load.
+     */
+    inline bool log_enabled(const log_level level)
+    {
+        return static_cast<int>(level) >= detail::log_threshold.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Queues a record on the lock-free log ring. Prefer BLINKSTICK_LOG, which skips
+     * building the fields entirely when the level is disabled.
+     * @details Never blocks: if the background thread has fallen behind and the ring is full the
+     * record is dropped and counted.
+     */
+    template<typename... Fields>
+    void log(const log_level level, const char* message, Fields&&... fields)
+    {
+        static_assert(sizeof...(Fields) <= log_record::max_fields, "too many log fields");
+        log_record record;
+        record.level = level;
+        record.message = message;
+        record.field_count = sizeof...(Fields);
+        size_t index = 0;
+        ((record.fields[index++] = log_field(std::forward<Fields>(fields))), ...);
+        static_cast<void>(index);
+        detail::log_write(record);
+    }
+
+    /**
+     * @brief Only keeps records at or above the given level. Defaults to off.
+     */
+    void BLINKSTICKCPP_EXPORT set_log_level(log_level level);
+
+    log_level BLINKSTICKCPP_EXPORT get_log_level();
+
+    /**
+     * @brief Replaces where records end up. Called on the background logging thread.
+     * @details The default sink writes one line per record to stdout. A sink may log, replace
+     * itself or call flush_log(), which returns at once on the logging thread.
+     */
+    void BLINKSTICKCPP_EXPORT set_log_sink(std::function<void(const log_record&)> sink);
+
+    /**
+     * @brief Formats a record as "LEVEL message key=value ...".
+     */
+    std::string BLINKSTICKCPP_EXPORT format_log_record(const log_record& record);
+
+    /**
+     * @brief Blocks until every record queued so far has reached the sink.
+     */
+    void BLINKSTICKCPP_EXPORT flush_log();
+
+    /**
+     * @brief Number of records dropped because the ring was full.
+     */
+    uint64_t BLINKSTICKCPP_EXPORT dropped_log_records();
+}
+
+#ifdef BLINKSTICKCPP_NO_LOGGING
+#define BLINKSTICK_LOG(level, ...) \
+    do                             \
+    {                              \
+    } while (0)
+#else
+/**
+ * @brief Logs a message with optional log_field arguments. The arguments are not evaluated
+ * unless the level is enabled; define BLINKSTICKCPP_NO_LOGGING to compile logging out entirely.
+ */
+#define BLINKSTICK_LOG(level, ...)                        \
+    do                                                    \
+    {                                                     \
+        if (::blinkstick::log_enabled(level))             \
+        {                                                 \
+            ::blinkstick::log((level), __VA_ARGS__);      \
+        }                                                 \
+    } while (0)
+#endif
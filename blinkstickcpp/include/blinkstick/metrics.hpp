@@ -0,0 +1,85 @@
+#pragma once
+
+#include <blinkstick/async_writer.hpp>
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace blinkstick
+{
+    /**
+     * @brief A device to export metrics for.
+     */
+    struct metrics_source
+    {
+        /**
+         * @brief Value of the device label, e.g. the serial number.
+         */
+        std::string name;
+        device target;
+
+        /**
+         * @brief Optional writer feeding the device, whose dropped frames are exported too.
+         */
+        const async_writer* writer = nullptr;
+    };
+
+    /**
+     * @brief Renders the counters and transfer latencies of the sources in the OpenMetrics text format.
+     * @details Only reads snapshots of the always-on device counters, so it never touches the
+     * frame path.
+     */
+    std::string BLINKSTICKCPP_EXPORT render_openmetrics(const std::vector<metrics_source>& sources);
+
+    /**
+     * @brief Replaces a file atomically, so a scraper never reads a half written file.
+     * @return true if the file was written.
+     */
+    bool BLINKSTICKCPP_EXPORT write_file_atomically(const std::string& path, const std::string& contents);
+
+    /**
+     * @brief Periodically writes the metrics of a set of devices to a file, e.g. for the
+     * node_exporter textfile collector.
+     */
+    class BLINKSTICKCPP_EXPORT metrics_file_exporter
+    {
+    public:
+        metrics_file_exporter(
+            std::string path,
+            std::chrono::milliseconds interval,
+            std::vector<metrics_source> sources);
+
+        /**
+         * @brief Writes the file one last time and stops.
+         */
+        ~metrics_file_exporter();
+
+        metrics_file_exporter(const metrics_file_exporter&) = delete;
+        metrics_file_exporter& operator=(const metrics_file_exporter&) = delete;
+
+        void set_sources(std::vector<metrics_source> sources);
+
+        /**
+         * @brief Writes the file now rather than waiting for the next interval.
+         */
+        bool write_now();
+
+    private:
+        void run();
+
+        const std::string path;
+        const std::chrono::milliseconds interval;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<metrics_source> sources;
+        bool stopping = false;
+
+        std::thread worker;
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <blinkstick/transport.hpp>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blinkstick
+{
+    /**
+     * @brief Long-lived set of the devices a backend can see.
+     * @details The bus is enumerated once, when the registry is created, and only again when
+     * refresh() is called. Devices are opened on first lookup and the handle is kept, so looking a
+     * device up again by serial or path is a hash lookup with no I/O. Safe to use from several
+     * threads.
+     */
+    class BLINKSTICKCPP_EXPORT registry
+    {
+    public:
+        explicit registry(backend backend = backend::hidapi);
+
+        /**
+         * @brief Enumerates the bus again. Devices that are still present keep their open handle.
+         */
+        void refresh();
+
+        /**
+         * @brief Adds a single device without enumerating the bus.
+         * @return false if a device with the same path is already known.
+         */
+        bool add(device_info info);
+
+        /**
+         * @brief Forgets a single device, closing its handle once no copies of it are left.
+         * @return the metadata of the removed device, if it was known.
+         */
+        std::optional<device_info> remove(const std::string& path);
+
+        /**
+         * @brief The metadata of every known device.
+         */
+        std::vector<device_info> entries() const;
+
+        size_t size() const;
+
+        /**
+         * @brief Returns the device with the given path, opening it if needed.
+         * @return the device, which is not valid if it is unknown or could not be opened.
+         */
+        device get_by_path(const std::string& path);
+
+        /**
+         * @brief Returns the device with the given serial number, opening it if needed.
+         * @return the device, which is not valid if it is unknown or could not be opened.
+         */
+        device get_by_serial(const std::string& serial);
+
+        /**
+         * @brief Opens every known device that is not open yet.
+         * @return the devices that could be opened.
+         */
+        std::vector<device> open_all();
+
+        backend get_backend() const;
+
+    private:
+        struct entry
+        {
+            device_info info;
+            std::optional<device> handle;
+        };
+
+        device open(entry& entry);
+
+        const backend source;
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, entry> by_path;
+        std::unordered_map<std::string, std::string> serial_to_path;
+    };
+}
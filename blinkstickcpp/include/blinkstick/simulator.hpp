@@ -0,0 +1,142 @@
+#pragma once
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/export.hpp>
+#include <blinkstick/transport.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace blinkstick
+{
+    /**
+     * @brief Timing and failure behaviour applied to each feature report the simulator handles.
+     */
+    struct report_profile
+    {
+        /**
+         * @brief Time every report takes before it completes.
+         */
+        std::chrono::nanoseconds latency{ 0 };
+
+        /**
+         * @brief Upper bound of a uniformly distributed delay added on top of latency.
+         */
+        std::chrono::nanoseconds jitter{ 0 };
+
+        /**
+         * @brief Probability in [0, 1] that a report fails.
+         */
+        double failure_rate = 0.0;
+    };
+
+    /**
+     * @brief In-process BlinkStick that understands the feature reports the library sends.
+     * @details Handles the single LED reports (1 and 5), the mode report (4), the bulk colour
+     * reports (6 - 10) and the LED count report (0x81), keeping the resulting LED state so it can
+     * be inspected. Latency and failures can be injected per report ID to measure throughput and
+     * tail latency without hardware. Safe to use from several threads.
+     */
+    class BLINKSTICKCPP_EXPORT simulator : public transport
+    {
+    public:
+        static constexpr int channel_count = 3;
+        static constexpr int max_leds = 64;
+
+        /**
+         * @brief Creates a simulated device.
+         * @param type the device type to report from find_all().
+         * @param led_count the LED count reported through report 0x81.
+         * @param seed the seed for jitter and failure injection.
+         */
+        explicit simulator(device_type type = device_type::flex, uint8_t led_count = 32, uint32_t seed = 0);
+
+        /**
+         * @brief Makes a simulator discoverable through find_all(backend::simulator).
+         */
+        static void plug(std::shared_ptr<simulator> sim);
+
+        /**
+         * @brief Removes every simulator added with plug().
+         */
+        static void unplug_all();
+
+        /**
+         * @brief The devices of every plugged simulator, in the order they were plugged.
+         */
+        static std::vector<device> find_all();
+
+        /**
+         * @brief Describes every plugged simulator, with paths of the form "simulator:N" and serials "SIMN".
+         */
+        static std::vector<device_info> enumerate();
+
+        /**
+         * @brief Returns the plugged simulator with the given path, or nullptr.
+         */
+        static std::shared_ptr<simulator> open(const std::string& path);
+
+        bool send_feature_report(const uint8_t* data, size_t size) override;
+
+        bool get_feature_report(uint8_t* data, size_t size) override;
+
+        /**
+         * @brief Sets the behaviour of reports that have no report specific profile.
+         */
+        void set_profile(const report_profile& profile);
+
+        /**
+         * @brief Sets the behaviour of a single report ID.
+         */
+        void set_profile(uint8_t report_id, const report_profile& profile);
+
+        device_type get_type() const;
+
+        /**
+         * @brief Returns the emulated colour of an LED, or black if out of range.
+         */
+        colour get_colour(int channel, int index) const;
+
+        /**
+         * @brief Returns the emulated colours of all LEDs on a channel.
+         */
+        std::vector<colour> get_colours(int channel) const;
+
+        mode get_mode() const;
+
+        uint8_t get_led_count() const;
+
+        /**
+         * @brief Number of reports with the given ID that completed successfully.
+         */
+        uint64_t report_count(uint8_t report_id) const;
+
+        /**
+         * @brief Number of reports with the given ID that failed, injected or malformed.
+         */
+        uint64_t failure_count(uint8_t report_id) const;
+
+    private:
+        std::pair<std::chrono::nanoseconds, bool> draw(uint8_t report_id);
+        bool apply(const uint8_t* data, size_t size);
+        bool fill(uint8_t* data, size_t size);
+
+        const device_type type;
+        mutable std::mutex mutex;
+        std::mt19937 random;
+        report_profile default_profile;
+        std::map<uint8_t, report_profile> profiles;
+        std::array<std::array<colour, max_leds>, channel_count> leds;
+        mode current_mode = mode::normal;
+        uint8_t led_count;
+        std::array<uint64_t, 256> reports{};
+        std::array<uint64_t, 256> failures{};
+    };
+}
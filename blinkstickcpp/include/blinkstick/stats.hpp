@@ -0,0 +1,119 @@
+#pragma once
+
+#include <blinkstick/export.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace blinkstick
+{
+    /**
+     * @brief Point in time copy of a latency_histogram.
+     */
+    struct BLINKSTICKCPP_EXPORT histogram_snapshot
+    {
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+
+        /**
+         * @brief The latency below which the given fraction of samples fall.
+         * @param fraction a value in [0, 1], e.g. 0.99 for p99.
+         * @return the upper bound of the bucket holding that sample, never above the maximum.
+         */
+        std::chrono::nanoseconds percentile(double fraction) const;
+
+        std::chrono::nanoseconds mean() const;
+    };
+
+    /**
+     * @brief Log-linear (HDR style) histogram of latencies with lock-free recording.
+     * @details Every power of two is split into 16 equal buckets, so any recorded value is known to
+     * within about 6% from a nanosecond up to roughly 18 minutes, in a fixed amount of memory.
+     */
+    class BLINKSTICKCPP_EXPORT latency_histogram
+    {
+    public:
+        static constexpr int sub_bucket_bits = 4;
+        static constexpr int sub_bucket_count = 1 << sub_bucket_bits;
+        static constexpr int max_exponent = 40;
+        static constexpr int bucket_count = sub_bucket_count * (max_exponent - sub_bucket_bits + 2);
+
+        void record(std::chrono::nanoseconds latency);
+
+        histogram_snapshot snapshot() const;
+
+        static size_t bucket_index(uint64_t ns);
+
+        /**
+         * @brief The smallest value that falls in the bucket after index.
+         */
+        static uint64_t bucket_upper_bound(size_t index);
+
+    private:
+        std::array<std::atomic<uint64_t>, bucket_count> buckets{};
+        std::atomic<uint64_t> count{ 0 };
+        std::atomic<uint64_t> total_ns{ 0 };
+        std::atomic<uint64_t> max_ns{ 0 };
+    };
+
+    /**
+     * @brief Point in time copy of a device's counters.
+     */
+    struct stats_snapshot
+    {
+        /**
+         * @brief Successful sends, indexed by report ID.
+         */
+        std::array<uint64_t, 256> reports_sent{};
+
+        /**
+         * @brief Successful reads, indexed by report ID.
+         */
+        std::array<uint64_t, 256> reports_read{};
+
+        /**
+         * @brief Frames successfully written with set_colours().
+         */
+        uint64_t frames = 0;
+        uint64_t bytes_sent = 0;
+        uint64_t bytes_read = 0;
+        uint64_t errors = 0;
+        uint64_t retries = 0;
+        histogram_snapshot send_latency;
+        histogram_snapshot get_latency;
+    };
+
+    /**
+     * @brief Always-on counters for every transfer a device makes.
+     * @details Recording is a handful of relaxed atomic increments, cheap next to any USB transfer.
+     */
+    class BLINKSTICKCPP_EXPORT device_stats
+    {
+    public:
+        void record_send(uint8_t report_id, size_t size, std::chrono::nanoseconds latency, bool ok);
+
+        void record_get(uint8_t report_id, size_t size, std::chrono::nanoseconds latency, bool ok);
+
+        void record_retry();
+
+        void record_frame();
+
+        stats_snapshot snapshot() const;
+
+    private:
+        std::array<std::atomic<uint64_t>, 256> reports_sent{};
+        std::array<std::atomic<uint64_t>, 256> reports_read{};
+        std::atomic<uint64_t> frames{ 0 };
+        std::atomic<uint64_t> bytes_sent{ 0 };
+        std::atomic<uint64_t> bytes_read{ 0 };
+        std::atomic<uint64_t> errors{ 0 };
+        std::atomic<uint64_t> retries{ 0 };
+        latency_histogram send_latency;
+        latency_histogram get_latency;
+    };
+}
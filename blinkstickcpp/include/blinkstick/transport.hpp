@@ -0,0 +1,46 @@
+#pragma once
+
+#include <blinkstick/export.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace blinkstick
+{
+    /**
+     * @brief Available I/O backends that find_all() can discover devices with.
+     */
+    enum class backend
+    {
+        hidapi,
+        hidraw,
+        simulator
+    };
+
+    /**
+     * @brief Moves HID feature reports between a device and the host.
+     * @details Every request the library makes to a BlinkStick goes through one of these, so the
+     * rest of the library does not care whether the bytes end up in hidapi, a raw kernel node or
+     * somewhere else entirely. The first byte of every buffer is the report ID.
+     */
+    class BLINKSTICKCPP_EXPORT transport
+    {
+    public:
+        virtual ~transport() = default;
+
+        /**
+         * @brief Sends a feature report to the device.
+         * @param data the report, starting with the report ID.
+         * @param size the number of bytes in data.
+         * @return true if the report was sent.
+         */
+        virtual bool send_feature_report(const uint8_t* data, size_t size) = 0;
+
+        /**
+         * @brief Reads a feature report from the device.
+         * @param data buffer whose first byte holds the report ID to read, filled with the report.
+         * @param size the number of bytes in data.
+         * @return true if the report was read.
+         */
+        virtual bool get_feature_report(uint8_t* data, size_t size) = 0;
+    };
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <blinkstick/device.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace blinkstick
+{
+    /**
+     * @brief The bulk colour report used for a number of LEDs on one channel.
+     */
+    struct report_layout
+    {
+        uint8_t report_id;
+
+        /**
+         * @brief The number of LEDs the report carries.
+         */
+        int max_leds;
+
+        /**
+         * @brief Bytes in the report: the report ID, the channel and a GRB triplet per LED.
+         */
+        size_t size;
+    };
+
+    /**
+     * @brief The most LEDs a single bulk colour report carries.
+     */
+    constexpr int max_leds_per_channel = 64;
+
+    /**
+     * @brief The smallest bulk colour report (6 - 9) that holds led_count LEDs, or report 10 above 64.
+     */
+    constexpr report_layout bulk_report_for(const int led_count)
+    {
+        if (led_count <= 8)
+        {
+            return { 6, 8, 8 * 3 + 2 };
+        }
+        if (led_count <= 16)
+        {
+            return { 7, 16, 16 * 3 + 2 };
+        }
+        if (led_count <= 32)
+        {
+            return { 8, 32, 32 * 3 + 2 };
+        }
+        if (led_count <= 64)
+        {
+            return { 9, 64, 64 * 3 + 2 };
+        }
+        return { 10, 64, 64 * 3 + 2 };
+    }
+
+    /**
+     * @brief The LED count of models that have a fixed number of LEDs, or 0 for models whose
+     * count is configured on the device (Pro and Flex).
+     */
+    constexpr int fixed_led_count(const device_type type)
+    {
+        switch (type)
+        {
+        case device_type::basic:
+            return 1;
+        case device_type::square:
+        case device_type::strip:
+            return 8;
+        case device_type::nano:
+            return 2;
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * @brief The number of channels a model drives. Unknown models are assumed to have as many
+     * as the protocol allows.
+     */
+    constexpr int channel_count(const device_type type)
+    {
+        switch (type)
+        {
+        case device_type::pro:
+        case device_type::unknown:
+            return 3;
+        default:
+            return 1;
+        }
+    }
+
+    /**
+     * @brief What is known about a model at compile time.
+     */
+    template<device_type Type>
+    struct device_traits
+    {
+        static constexpr int channels = channel_count(Type);
+
+        /**
+         * @brief The LED count, or the default for models where it is configurable.
+         */
+        static constexpr int led_count = fixed_led_count(Type);
+        static constexpr int max_leds = fixed_led_count(Type);
+        static constexpr bool configurable = false;
+    };
+
+    template<>
+    struct device_traits<device_type::flex>
+    {
+        static constexpr int channels = 1;
+        static constexpr int led_count = 32;
+        static constexpr int max_leds = 64;
+        static constexpr bool configurable = true;
+    };
+
+    template<>
+    struct device_traits<device_type::pro>
+    {
+        static constexpr int channels = 3;
+        static constexpr int led_count = 64;
+
+        /**
+         * @brief A strip can run on across all three channels.
+         */
+        static constexpr int max_leds = 3 * max_leds_per_channel;
+        static constexpr bool configurable = true;
+    };
+
+    /**
+     * @brief A device whose model and LED count are known at compile time.
+     * @details The report ID, its size and the LED count are constants, and frames are built in
+     * a std::array on the stack, so sending a frame skips the LED count lookup, the report
+     * selection and delta encoding entirely. Wraps a device, which it shares state with.
+     */
+    template<device_type Type, int LedCount = device_traits<Type>::led_count>
+    class fixed_device
+    {
+    public:
+        using traits = device_traits<Type>;
+
+        static_assert(Type != device_type::unknown, "the model must be known");
+        static_assert(LedCount > 0 && LedCount <= traits::max_leds, "the model does not support that many LEDs");
+        static_assert(traits::configurable || LedCount == traits::led_count, "the model has a fixed LED count");
+
+        static constexpr int led_count = LedCount;
+        static constexpr int channels = traits::channels;
+        /**
+         * @brief Strips longer than one report carries run on across consecutive channels.
+         */
+        static constexpr int segments = (LedCount + max_leds_per_channel - 1) / max_leds_per_channel;
+
+        /**
+         * @brief The report of every segment but the last, which may be smaller.
+         */
+        static constexpr report_layout layout = bulk_report_for(segments > 1 ? max_leds_per_channel : LedCount);
+        static constexpr report_layout last_layout = bulk_report_for(LedCount - (segments - 1) * max_leds_per_channel);
+
+        using frame = std::array<colour, LedCount>;
+
+        explicit fixed_device(device target) :
+            target(std::move(target))
+        {
+        }
+
+        /**
+         * @brief Whether the wrapped device is open and of the right model.
+         */
+        bool is_valid() const
+        {
+            return target.is_valid() && target.get_type() == Type;
+        }
+
+        /**
+         * @brief Sets the LED count on models where it is configurable, so the device matches LedCount.
+         */
+        bool configure() const
+        {
+            if constexpr (traits::configurable)
+            {
+                return target.set_led_count(static_cast<uint8_t>(LedCount));
+            }
+            return true;
+        }
+
+        template<int Channel = 0>
+        bool set_colours(const frame& colours) const
+        {
+            static_assert(Channel >= 0 && Channel + segments <= channels, "the model does not have that channel");
+            if constexpr (Type == device_type::basic)
+            {
+                // The original BlinkStick only understands the single LED report
+                return target.set_colour(Channel, 0, colours[0].red, colours[0].green, colours[0].blue);
+            }
+            else
+            {
+                std::array<uint8_t, layout.size> report;
+                for (int segment = 0; segment + 1 < segments; ++segment)
+                {
+                    const auto* first = colours.data() + segment * max_leds_per_channel;
+                    if (!target.send_colours(layout.report_id, Channel + segment, first, max_leds_per_channel, report.data(), layout.size))
+                    {
+                        return false;
+                    }
+                }
+                const auto* last = colours.data() + (segments - 1) * max_leds_per_channel;
+                return target.send_colours(
+                    last_layout.report_id,
+                    Channel + segments - 1,
+                    last,
+                    LedCount - (segments - 1) * max_leds_per_channel,
+                    report.data(),
+                    last_layout.size);
+            }
+        }
+
+        const device& get_device() const
+        {
+            return target;
+        }
+
+    private:
+        device target;
+    };
+
+    using basic_device = fixed_device<device_type::basic>;
+    using square_device = fixed_device<device_type::square>;
+    using strip_device = fixed_device<device_type::strip>;
+    using nano_device = fixed_device<device_type::nano>;
+
+    template<int LedCount = device_traits<device_type::flex>::led_count>
+    using flex_device = fixed_device<device_type::flex, LedCount>;
+
+    template<int LedCount = device_traits<device_type::pro>::led_count>
+    using pro_device = fixed_device<device_type::pro, LedCount>;
+}
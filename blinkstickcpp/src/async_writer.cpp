@@ -0,0 +1,129 @@
+#include "blinkstick/async_writer.hpp"
+#include "blinkstick/variant.hpp"
+
+#include <utility>
+
+namespace blinkstick
+{
+    async_writer::async_writer(device target) :
+        target(std::move(target)),
+        slots(static_cast<size_t>(channel_count(this->target.get_type()))),
+        worker(&async_writer::run, this)
+    {
+    }
+
+    async_writer::~async_writer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    bool async_writer::submit(const int channel, const colour* colours, const size_t count)
+    {
+        if (channel < 0 || static_cast<size_t>(channel) >= slots.size())
+        {
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+            {
+                return false;
+            }
+            ++submitted;
+
+            auto& frame = slots[channel];
+            if (frame.pending)
+            {
+                ++dropped;
+            }
+            else
+            {
+                frame.pending = true;
+                ++pending;
+            }
+            frame.next.assign(colours, colours + count);
+        }
+        wake.notify_one();
+        return true;
+    }
+
+    bool async_writer::submit(const int channel, const std::vector<colour>& colours)
+    {
+        return submit(channel, colours.data(), colours.size());
+    }
+
+    void async_writer::flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return pending == 0 && !busy; });
+    }
+
+    async_stats async_writer::get_stats() const
+    {
+        async_stats stats;
+        stats.submitted = submitted;
+        stats.sent = sent;
+        stats.failed = failed;
+        stats.dropped = dropped;
+        return stats;
+    }
+
+    void async_writer::run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [this] { return stopping || pending != 0; });
+            if (pending == 0)
+            {
+                break;
+            }
+
+            // Swapping keeps both buffers' capacity, so neither side allocates once warm
+            for (auto& frame : slots)
+            {
+                if (frame.pending)
+                {
+                    frame.next.swap(frame.sending);
+                    frame.pending = false;
+                    frame.ready = true;
+                }
+            }
+            pending = 0;
+            busy = true;
+            lock.unlock();
+
+            for (size_t channel = 0; channel < slots.size(); ++channel)
+            {
+                auto& frame = slots[channel];
+                if (!frame.ready)
+                {
+                    continue;
+                }
+                frame.ready = false;
+                if (target.set_colours(static_cast<int>(channel), frame.sending.data(), frame.sending.size()))
+                {
+                    ++sent;
+                }
+                else
+                {
+                    ++failed;
+                }
+            }
+
+            lock.lock();
+            busy = false;
+            if (pending == 0)
+            {
+                idle.notify_all();
+            }
+        }
+        idle.notify_all();
+    }
+}
@@ -1,9 +1,12 @@
 #include "blinkstick/blinkstick.hpp"
+#include "blinkstick/hidapi_transport.hpp"
+#include "blinkstick/log.hpp"
+#include "blinkstick/simulator.hpp"
+#include "hidraw.hpp"
 
 #include <hidapi/hidapi.h>
 
 #include <array>
-#include <cstdarg>
 #include <string>
 
 namespace
@@ -12,12 +15,10 @@ namespace
     constexpr int VENDOR_ID = 0X20A0;
     constexpr int PRODUCT_ID = 0X41E5;
 
-    bool print_debug = false;
-
-    std::shared_ptr<hid_device> get_device(hid_device_info* device_info)
+    std::shared_ptr<hid_device> get_device(const std::string& path)
     {
         return std::shared_ptr<hid_device>(
-            hid_open_path(device_info->path),
+            hid_open_path(path.c_str()),
             [](hid_device* device)
             {
                 if (device)
@@ -26,52 +27,52 @@ namespace
                 }
             });
     }
-}
 
-namespace blinkstick
-{
-    void debug(const char* fmt, ...)
+    std::string get_serial(hid_device_info* device_info)
     {
-        if (print_debug)
+        if (device_info->serial_number == nullptr)
         {
-            char buffer[256];
-            va_list ap;
-            va_start(ap, fmt);
-            vsprintf(buffer, fmt, ap);
-            va_end(ap);
-
-            puts(buffer);
+            return {};
+        }
+        // BlinkStick serials are plain ASCII, e.g. BS000001-3.0
+        std::string serial;
+        for (const wchar_t* c = device_info->serial_number; *c != L'\0'; ++c)
+        {
+            serial.push_back(static_cast<char>(*c));
         }
+        return serial;
     }
+}
 
+namespace blinkstick
+{
     void enable_logging()
     {
-        print_debug = true;
-        debug("STARTING BLINKSTICK WITH DEBUG LOGGING");
+        set_log_level(log_level::debug);
+        BLINKSTICK_LOG(log_level::info, "STARTING BLINKSTICK WITH DEBUG LOGGING");
     }
 
-    int get_major_version(hid_device_info* device_info)
+    int get_major_version(const std::string& serial)
     {
-        if(device_info->serial_number == nullptr)
+        if (serial.size() < 3)
         {
-            debug("No serial number");
+            BLINKSTICK_LOG(log_level::warning, "No serial number");
             return 0;
         }
-        const std::wstring serial = device_info->serial_number;
         try
         {
             return std::stoi(serial.substr(serial.size() - 3, 1));
         }
         catch (const std::exception&)
         {
-            debug("Failed to parse serial number");
+            BLINKSTICK_LOG(log_level::warning, "Failed to parse serial number", log_field("serial", serial));
         }
         return 0;
     }
 
-    device_type get_type(hid_device_info* device_info)
+    device_type get_type(const std::string& serial, const uint16_t release_number)
     {
-        const auto major_version = get_major_version(device_info);
+        const auto major_version = get_major_version(serial);
 
         if (major_version == 1)
         {
@@ -83,7 +84,7 @@ namespace blinkstick
         }
         else if (major_version == 3)
         {
-            switch (device_info->release_number)
+            switch (release_number)
             {
             case 0x0200:
                 return device_type::square;
@@ -98,15 +99,15 @@ namespace blinkstick
         return device_type::unknown;
     }
 
-    std::vector<device> find_all()
+    std::vector<device_info> enumerate_hidapi()
     {
-        std::vector<device> devices;
+        std::vector<device_info> devices;
 
-        debug("initializing usb context");
+        BLINKSTICK_LOG(log_level::debug, "initializing usb context");
         const int res = hid_init();
         if (res != 0)
         {
-            debug("failed to initialize hid");
+            BLINKSTICK_LOG(log_level::error, "failed to initialize hid", log_field("result", res));
             return devices;
         }
 
@@ -115,34 +116,91 @@ namespace blinkstick
         {
             return devices;
         }
-        auto device_info = all_devices;
 
-        do
+        for (auto info = all_devices; info != nullptr; info = info->next)
         {
-            if(auto device = get_device(device_info); !device)
-            {
-                debug("could not open device");
-            }
-            else
-            {
-                debug("found device: %s", device_info->path);
-                devices.emplace_back(std::move(device), get_type(device_info));
-            }
-        } while ((device_info = device_info->next));
+            BLINKSTICK_LOG(log_level::debug, "found device", log_field("path", info->path));
+            auto serial = get_serial(info);
+            const auto type = get_type(serial, info->release_number);
+            devices.push_back(device_info{ info->path, std::move(serial), type });
+        }
 
         hid_free_enumeration(all_devices);
 
         return devices;
     }
 
-    device find()
+    std::shared_ptr<transport> open_hidapi(const std::string& path)
     {
-        const auto devices = find_all();
-        if (devices.empty())
+        auto handle = get_device(path);
+        if (!handle)
         {
-            return device{ nullptr, device_type::unknown };
+            return nullptr;
+        }
+        return std::make_shared<hidapi_transport>(std::move(handle));
+    }
+
+    std::vector<device_info> enumerate(const backend backend)
+    {
+        switch (backend)
+        {
+        case backend::hidapi:
+            return enumerate_hidapi();
+        case backend::hidraw:
+            return enumerate_hidraw();
+        case backend::simulator:
+            return simulator::enumerate();
+        }
+        return {};
+    }
+
+    device open_device(const device_info& info, const backend backend)
+    {
+        std::shared_ptr<transport> io;
+        switch (backend)
+        {
+        case backend::hidapi:
+            io = open_hidapi(info.path);
+            break;
+        case backend::hidraw:
+            io = open_hidraw(info.path);
+            break;
+        case backend::simulator:
+            io = simulator::open(info.path);
+            break;
+        }
+
+        if (!io)
+        {
+            BLINKSTICK_LOG(log_level::warning, "could not open device", log_field("path", info.path));
+        }
+        return device{ std::move(io), info.type };
+    }
+
+    std::vector<device> find_all(const backend backend)
+    {
+        std::vector<device> devices;
+        for (const auto& info : enumerate(backend))
+        {
+            if (auto device = open_device(info, backend); device.is_valid())
+            {
+                devices.emplace_back(std::move(device));
+            }
+        }
+        return devices;
+    }
+
+    device find(const backend backend)
+    {
+        // Only open devices until one succeeds rather than opening them all
+        for (const auto& info : enumerate(backend))
+        {
+            if (auto device = open_device(info, backend); device.is_valid())
+            {
+                return device;
+            }
         }
-        return devices.front();
+        return device{ std::shared_ptr<transport>(), device_type::unknown };
     }
 
     void finalise()
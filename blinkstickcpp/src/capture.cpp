@@ -0,0 +1,261 @@
+#include "blinkstick/capture.hpp"
+#include "blinkstick/log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BLINKSTICK_HAS_MMAP 1
+#endif
+
+namespace
+{
+    constexpr std::array<uint8_t, 8> MAGIC = { 'B', 'S', 'T', 'K', 'C', 'A', 'P', 0 };
+    constexpr uint32_t VERSION = 1;
+    constexpr size_t HEADER_SIZE = 16;
+    constexpr size_t RECORD_HEADER_SIZE = 12;
+
+    void put_le(uint8_t* out, uint64_t value, const size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i, value >>= 8)
+        {
+            out[i] = static_cast<uint8_t>(value);
+        }
+    }
+
+    uint64_t get_le(const uint8_t* in, const size_t bytes)
+    {
+        uint64_t value = 0;
+        for (size_t i = bytes; i > 0; --i)
+        {
+            value = (value << 8) | in[i - 1];
+        }
+        return value;
+    }
+}
+
+namespace blinkstick
+{
+    std::shared_ptr<recording_transport> recording_transport::open(
+        const std::string& path,
+        std::shared_ptr<transport> inner)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            BLINKSTICK_LOG(log_level::error, "could not create capture file", log_field("path", path));
+            return nullptr;
+        }
+
+        std::array<uint8_t, HEADER_SIZE> header{};
+        std::memcpy(header.data(), MAGIC.data(), MAGIC.size());
+        put_le(header.data() + 8, VERSION, 4);
+        if (std::fwrite(header.data(), 1, header.size(), file) != header.size())
+        {
+            BLINKSTICK_LOG(log_level::error, "could not write capture header", log_field("path", path));
+            std::fclose(file);
+            return nullptr;
+        }
+        return std::make_shared<recording_transport>(file, std::move(inner));
+    }
+
+    recording_transport::recording_transport(std::FILE* file, std::shared_ptr<transport> inner) :
+        file(file),
+        inner(std::move(inner)),
+        start(std::chrono::steady_clock::now())
+    {
+    }
+
+    recording_transport::~recording_transport()
+    {
+        if (file)
+        {
+            std::fclose(file);
+        }
+    }
+
+    bool recording_transport::send_feature_report(const uint8_t* data, const size_t size)
+    {
+        const bool ok = inner && inner->send_feature_report(data, size);
+        record(capture_direction::send, ok, data, size);
+        return ok;
+    }
+
+    bool recording_transport::get_feature_report(uint8_t* data, const size_t size)
+    {
+        const bool ok = inner && inner->get_feature_report(data, size);
+        record(capture_direction::get, ok, data, size);
+        return ok;
+    }
+
+    bool recording_transport::flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return file && std::fflush(file) == 0;
+    }
+
+    void recording_transport::record(
+        const capture_direction direction,
+        const bool ok,
+        const uint8_t* data,
+        size_t size)
+    {
+        size = std::min<size_t>(size, UINT16_MAX);
+        std::array<uint8_t, RECORD_HEADER_SIZE> header;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file == nullptr)
+        {
+            return;
+        }
+
+        // Taken under the lock so records are always in time order
+        const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        put_le(header.data(), static_cast<uint64_t>(time.count()), 8);
+        put_le(header.data() + 8, size, 2);
+        header[10] = static_cast<uint8_t>(direction);
+        header[11] = ok ? 1 : 0;
+        if (std::fwrite(header.data(), 1, header.size(), file) != header.size()
+            || std::fwrite(data, 1, size, file) != size)
+        {
+            BLINKSTICK_LOG(log_level::error, "could not write capture record, stopping the capture");
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+
+#ifdef BLINKSTICK_HAS_MMAP
+    capture_reader::capture_reader(const std::string& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            BLINKSTICK_LOG(log_level::error, "could not open capture file", log_field("path", path));
+            return;
+        }
+
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= HEADER_SIZE)
+        {
+            void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED)
+            {
+                begin = static_cast<const uint8_t*>(mapping);
+                length = static_cast<size_t>(info.st_size);
+                ::madvise(mapping, length, MADV_SEQUENTIAL);
+            }
+        }
+        // The mapping keeps the file alive
+        ::close(fd);
+
+        if (begin == nullptr)
+        {
+            BLINKSTICK_LOG(log_level::error, "could not map capture file", log_field("path", path));
+            return;
+        }
+        if (std::memcmp(begin, MAGIC.data(), MAGIC.size()) != 0 || get_le(begin + 8, 4) != VERSION)
+        {
+            BLINKSTICK_LOG(log_level::error, "not a capture file", log_field("path", path));
+            ::munmap(const_cast<uint8_t*>(begin), length);
+            begin = nullptr;
+            length = 0;
+            return;
+        }
+        position = HEADER_SIZE;
+    }
+
+    capture_reader::~capture_reader()
+    {
+        if (begin)
+        {
+            ::munmap(const_cast<uint8_t*>(begin), length);
+        }
+    }
+#else
+    capture_reader::capture_reader(const std::string&)
+    {
+        BLINKSTICK_LOG(log_level::warning, "reading captures is only available on POSIX systems");
+    }
+
+    capture_reader::~capture_reader() = default;
+#endif
+
+    bool capture_reader::is_open() const
+    {
+        return begin != nullptr;
+    }
+
+    bool capture_reader::next(capture_record& record)
+    {
+        if (begin == nullptr || length - position < RECORD_HEADER_SIZE)
+        {
+            return false;
+        }
+        const uint8_t* header = begin + position;
+        const auto size = static_cast<size_t>(get_le(header + 8, 2));
+        if (length - position - RECORD_HEADER_SIZE < size)
+        {
+            return false;
+        }
+
+        record.time = std::chrono::nanoseconds(static_cast<int64_t>(get_le(header, 8)));
+        record.direction = static_cast<capture_direction>(header[10]);
+        record.ok = header[11] != 0;
+        record.data = header + RECORD_HEADER_SIZE;
+        record.size = size;
+        position += RECORD_HEADER_SIZE + size;
+        return true;
+    }
+
+    void capture_reader::rewind()
+    {
+        if (begin)
+        {
+            position = HEADER_SIZE;
+        }
+    }
+
+    replay_result replay(capture_reader& reader, transport& target, const double speed)
+    {
+        replay_result result;
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds first{ -1 };
+
+        capture_record record;
+        while (reader.next(record))
+        {
+            if (record.direction != capture_direction::send)
+            {
+                ++result.skipped;
+                continue;
+            }
+
+            if (speed > 0)
+            {
+                // Timed relative to the first replayed record, so replaying from the middle of a
+                // capture does not start with a long pause
+                if (first.count() < 0)
+                {
+                    first = record.time;
+                }
+                const auto offset = std::chrono::duration<double, std::nano>(record.time - first) / speed;
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::nanoseconds>(offset));
+            }
+
+            if (target.send_feature_report(record.data, record.size))
+            {
+                ++result.sent;
+            }
+            else
+            {
+                ++result.failed;
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,281 @@
+#include "blinkstick/colour_space.hpp"
+#include "packing.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BLINKSTICK_X86_KERNELS 1
+#endif
+
+// Both conversions reduce to a chroma C, an offset m and the hue: the sector of the hue wheel
+// decides which channel gets C, which gets the intermediate X and which gets nothing, and m is
+// added to all three. Everything stays in 16 bits, dividing by 255 with a multiply-free rounding
+// trick, so the scalar and vector paths agree to the bit.
+namespace
+{
+    using blinkstick::colour;
+    using blinkstick::hsl;
+    using blinkstick::hsv;
+
+    static_assert(sizeof(hsv) == 3 && sizeof(hsl) == 3, "colour arrays are treated as packed triplets");
+
+    enum class model
+    {
+        hsv,
+        hsl
+    };
+
+    // Rounded x / 255 for x <= 65535 - 128
+    constexpr int div255(const int x)
+    {
+        return (x + 128 + ((x + 128) >> 8)) >> 8;
+    }
+
+    template<model Model>
+    colour convert(const uint8_t hue, const uint8_t saturation, const uint8_t level)
+    {
+        int chroma;
+        int offset;
+        if constexpr (Model == model::hsv)
+        {
+            chroma = div255(level * saturation);
+            offset = level - chroma;
+        }
+        else
+        {
+            chroma = div255((255 - std::abs(2 * level - 255)) * saturation);
+            offset = level - (chroma >> 1);
+        }
+
+        const int position = hue * 6;
+        const int sector = position >> 8;
+        const int fraction = position & 0xFF;
+        const int x = div255(chroma * ((sector & 1) ? 255 - fraction : fraction));
+
+        const auto channel = [offset](const int value) { return static_cast<uint8_t>(std::min(value + offset, 255)); };
+        switch (sector)
+        {
+        case 0:
+            return colour{ channel(chroma), channel(x), channel(0) };
+        case 1:
+            return colour{ channel(x), channel(chroma), channel(0) };
+        case 2:
+            return colour{ channel(0), channel(chroma), channel(x) };
+        case 3:
+            return colour{ channel(0), channel(x), channel(chroma) };
+        case 4:
+            return colour{ channel(x), channel(0), channel(chroma) };
+        default:
+            return colour{ channel(chroma), channel(0), channel(x) };
+        }
+    }
+
+    template<model Model>
+    void convert_scalar(const uint8_t* in, const size_t count, colour* out)
+    {
+        for (size_t i = 0; i < count; ++i, in += 3)
+        {
+            out[i] = convert<Model>(in[0], in[1], in[2]);
+        }
+    }
+
+#ifdef BLINKSTICK_X86_KERNELS
+    // pshufb masks that split 48 bytes of triplets into three 16 byte planes and back
+    struct shuffle_masks
+    {
+        // [plane][source register]
+        alignas(16) std::array<std::array<std::array<int8_t, 16>, 3>, 3> split;
+        // [destination register][plane]
+        alignas(16) std::array<std::array<std::array<int8_t, 16>, 3>, 3> join;
+    };
+
+    constexpr shuffle_masks make_masks()
+    {
+        shuffle_masks masks{};
+        for (int plane = 0; plane < 3; ++plane)
+        {
+            for (int reg = 0; reg < 3; ++reg)
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    // Byte i of the plane is byte 3i + plane of the triplets
+                    const int source = 3 * i + plane;
+                    masks.split[plane][reg][i] = static_cast<int8_t>(source / 16 == reg ? source % 16 : -1);
+
+                    // Byte i of register reg is element (16 reg + i) / 3 of plane (16 reg + i) % 3
+                    const int target = 16 * reg + i;
+                    masks.join[reg][plane][i] = static_cast<int8_t>(target % 3 == plane ? target / 3 : -1);
+                }
+            }
+        }
+        return masks;
+    }
+
+    constexpr shuffle_masks MASKS = make_masks();
+
+    __attribute__((target("ssse3"))) inline __m128i load_mask(const std::array<int8_t, 16>& mask)
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(mask.data()));
+    }
+
+    __attribute__((target("ssse3"))) inline __m128i gather(const __m128i* registers, const std::array<std::array<int8_t, 16>, 3>& masks)
+    {
+        return _mm_or_si128(
+            _mm_or_si128(_mm_shuffle_epi8(registers[0], load_mask(masks[0])), _mm_shuffle_epi8(registers[1], load_mask(masks[1]))),
+            _mm_shuffle_epi8(registers[2], load_mask(masks[2])));
+    }
+
+    __attribute__((target("ssse3"))) inline __m128i div255(const __m128i x)
+    {
+        const __m128i rounded = _mm_add_epi16(x, _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)), 8);
+    }
+
+    __attribute__((target("ssse3"))) inline __m128i select(const __m128i mask, const __m128i value, const __m128i otherwise)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, value), _mm_andnot_si128(mask, otherwise));
+    }
+
+    // Converts 8 colours held as 16 bit lanes, returning the red, green and blue lanes
+    template<model Model>
+    __attribute__((target("ssse3"))) inline void convert_lanes(
+        const __m128i hue,
+        const __m128i saturation,
+        const __m128i level,
+        __m128i& red,
+        __m128i& green,
+        __m128i& blue)
+    {
+        const __m128i full = _mm_set1_epi16(255);
+        __m128i chroma;
+        __m128i offset;
+        if constexpr (Model == model::hsv)
+        {
+            chroma = div255(_mm_mullo_epi16(level, saturation));
+            offset = _mm_sub_epi16(level, chroma);
+        }
+        else
+        {
+            // 255 - |2l - 255| is 2l for l <= 127 and 510 - 2l above
+            const __m128i doubled = _mm_add_epi16(level, level);
+            const __m128i span = _mm_min_epi16(doubled, _mm_sub_epi16(_mm_set1_epi16(510), doubled));
+            chroma = div255(_mm_mullo_epi16(span, saturation));
+            offset = _mm_sub_epi16(level, _mm_srli_epi16(chroma, 1));
+        }
+
+        const __m128i position = _mm_mullo_epi16(hue, _mm_set1_epi16(6));
+        const __m128i sector = _mm_srli_epi16(position, 8);
+        const __m128i fraction = _mm_and_si128(position, full);
+        const __m128i odd = _mm_cmpeq_epi16(_mm_and_si128(sector, _mm_set1_epi16(1)), _mm_set1_epi16(1));
+        const __m128i ramp = select(odd, _mm_sub_epi16(full, fraction), fraction);
+        const __m128i x = div255(_mm_mullo_epi16(chroma, ramp));
+        const __m128i zero = _mm_setzero_si128();
+
+        const __m128i s0 = _mm_cmpeq_epi16(sector, zero);
+        const __m128i s1 = _mm_cmpeq_epi16(sector, _mm_set1_epi16(1));
+        const __m128i s2 = _mm_cmpeq_epi16(sector, _mm_set1_epi16(2));
+        const __m128i s3 = _mm_cmpeq_epi16(sector, _mm_set1_epi16(3));
+        const __m128i s4 = _mm_cmpeq_epi16(sector, _mm_set1_epi16(4));
+        const __m128i s5 = _mm_cmpeq_epi16(sector, _mm_set1_epi16(5));
+
+        red = select(_mm_or_si128(s0, s5), chroma, select(_mm_or_si128(s1, s4), x, zero));
+        green = select(_mm_or_si128(s1, s2), chroma, select(_mm_or_si128(s0, s3), x, zero));
+        blue = select(_mm_or_si128(s3, s4), chroma, select(_mm_or_si128(s2, s5), x, zero));
+
+        red = _mm_add_epi16(red, offset);
+        green = _mm_add_epi16(green, offset);
+        blue = _mm_add_epi16(blue, offset);
+    }
+
+    template<model Model>
+    __attribute__((target("ssse3"))) void convert_ssse3(const uint8_t* in, const size_t count, colour* out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        auto* target = reinterpret_cast<uint8_t*>(out);
+
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const uint8_t* source = in + i * 3;
+            const __m128i triplets[3] = {
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 32)) };
+
+            const __m128i hue = gather(triplets, MASKS.split[0]);
+            const __m128i saturation = gather(triplets, MASKS.split[1]);
+            const __m128i level = gather(triplets, MASKS.split[2]);
+
+            __m128i red[2];
+            __m128i green[2];
+            __m128i blue[2];
+            convert_lanes<Model>(
+                _mm_unpacklo_epi8(hue, zero),
+                _mm_unpacklo_epi8(saturation, zero),
+                _mm_unpacklo_epi8(level, zero),
+                red[0],
+                green[0],
+                blue[0]);
+            convert_lanes<Model>(
+                _mm_unpackhi_epi8(hue, zero),
+                _mm_unpackhi_epi8(saturation, zero),
+                _mm_unpackhi_epi8(level, zero),
+                red[1],
+                green[1],
+                blue[1]);
+
+            const __m128i planes[3] = {
+                _mm_packus_epi16(red[0], red[1]),
+                _mm_packus_epi16(green[0], green[1]),
+                _mm_packus_epi16(blue[0], blue[1]) };
+
+            uint8_t* destination = target + i * 3;
+            for (int reg = 0; reg < 3; ++reg)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 16 * reg), gather(planes, MASKS.join[reg]));
+            }
+        }
+        convert_scalar<Model>(in + i * 3, count - i, out + i);
+    }
+#endif
+
+    template<model Model>
+    void convert_all(const uint8_t* in, const size_t count, colour* out)
+    {
+#ifdef BLINKSTICK_X86_KERNELS
+        static const bool vectorised = blinkstick::packing::supported(blinkstick::packing::kernel::ssse3);
+        if (vectorised)
+        {
+            convert_ssse3<Model>(in, count, out);
+            return;
+        }
+#endif
+        convert_scalar<Model>(in, count, out);
+    }
+}
+
+namespace blinkstick
+{
+    void hsv_to_rgb(const hsv* in, const size_t count, colour* out)
+    {
+        convert_all<model::hsv>(reinterpret_cast<const uint8_t*>(in), count, out);
+    }
+
+    void hsl_to_rgb(const hsl* in, const size_t count, colour* out)
+    {
+        convert_all<model::hsl>(reinterpret_cast<const uint8_t*>(in), count, out);
+    }
+
+    colour hsv_to_rgb(const hsv& in)
+    {
+        return convert<model::hsv>(in.hue, in.saturation, in.value);
+    }
+
+    colour hsl_to_rgb(const hsl& in)
+    {
+        return convert<model::hsl>(in.hue, in.saturation, in.lightness);
+    }
+}
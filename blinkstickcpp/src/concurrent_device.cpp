@@ -0,0 +1,195 @@
+#include "blinkstick/concurrent_device.hpp"
+#include "mpsc_ring.hpp"
+
+#include <chrono>
+
+namespace blinkstick
+{
+    struct concurrent_device::command
+    {
+        enum class kind
+        {
+            colour,
+            colours,
+            mode
+        };
+
+        kind type = kind::colour;
+        int channel = 0;
+        int index = 0;
+        colour value;
+        std::vector<colour> colours;
+        blinkstick::mode new_mode = blinkstick::mode::unknown;
+    };
+
+    struct concurrent_device::queue : mpsc_ring<command, 256>
+    {
+    };
+
+    concurrent_device::concurrent_device(device target) :
+        target(std::move(target)),
+        commands(std::make_unique<queue>()),
+        worker(&concurrent_device::run, this)
+    {
+    }
+
+    concurrent_device::~concurrent_device()
+    {
+        stopping = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    template<typename Fill>
+    bool concurrent_device::enqueue(Fill&& fill)
+    {
+        // Announce the push before checking stopping. run() checks entering after stopping is set,
+        // so either this thread backs out or the transport thread waits for the push and runs it
+        ++entering;
+        if (stopping)
+        {
+            --entering;
+            return false;
+        }
+        ++queued;
+        while (!commands->try_push(fill))
+        {
+            // Every cell is in use, let the transport thread catch up
+            std::this_thread::yield();
+        }
+
+        // Only take the lock when the transport thread is asleep. The claim in try_push() and this
+        // load pair with the store and idle() check in run(), so either this thread sees it
+        // sleeping or it sees the push
+        if (sleeping)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wake.notify_one();
+        }
+        --entering;
+        return true;
+    }
+
+    bool concurrent_device::set_colour(
+        const int channel,
+        const int index,
+        const uint8_t red,
+        const uint8_t green,
+        const uint8_t blue)
+    {
+        return enqueue([&](command& item) {
+            item.type = command::kind::colour;
+            item.channel = channel;
+            item.index = index;
+            item.value = colour{ red, green, blue };
+        });
+    }
+
+    bool concurrent_device::set_colours(const int channel, std::vector<colour> colours)
+    {
+        return enqueue([&](command& item) {
+            item.type = command::kind::colours;
+            item.channel = channel;
+            // Reuses the capacity the cell kept from earlier frames
+            item.colours.assign(colours.begin(), colours.end());
+        });
+    }
+
+    bool concurrent_device::set_mode(const mode mode)
+    {
+        return enqueue([&](command& item) {
+            item.type = command::kind::mode;
+            item.new_mode = mode;
+        });
+    }
+
+    void concurrent_device::flush()
+    {
+        const auto target_count = queued.load();
+        std::unique_lock<std::mutex> lock(mutex);
+        ++flushing;
+        drained.wait(lock, [&] { return executed.load() >= target_count; });
+        --flushing;
+    }
+
+    uint64_t concurrent_device::failed_commands() const
+    {
+        return failed;
+    }
+
+    const device& concurrent_device::get_device() const
+    {
+        return target;
+    }
+
+    void concurrent_device::run()
+    {
+        while (true)
+        {
+            while (auto* item = commands->front())
+            {
+                if (!execute(*item))
+                {
+                    ++failed;
+                }
+                commands->pop();
+                ++executed;
+
+                // Producers may keep the queue from ever emptying, so wake a waiting flush() here
+                // rather than only once drained. Either flush() sees the new count or this sees it waiting
+                if (flushing > 0)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    drained.notify_all();
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            drained.notify_all();
+
+            // Check entering before idle(): a producer that finished after the first check has
+            // already made its claim visible, and one that starts after it sees stopping and backs out
+            if (stopping && entering == 0 && commands->idle())
+            {
+                break;
+            }
+            if (!commands->idle() || stopping)
+            {
+                // A push is half way done, it will be poppable in a moment
+                lock.unlock();
+                std::this_thread::yield();
+                continue;
+            }
+
+            sleeping = true;
+            if (commands->idle() && !stopping)
+            {
+                // The timeout only bounds the damage should a wake-up ever be missed
+                wake.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            sleeping = false;
+        }
+    }
+
+    bool concurrent_device::execute(const command& command)
+    {
+        switch (command.type)
+        {
+        case command::kind::colour:
+            return target.set_colour(
+                command.channel,
+                command.index,
+                command.value.red,
+                command.value.green,
+                command.value.blue);
+        case command::kind::colours:
+            return target.set_colours(command.channel, command.colours);
+        case command::kind::mode:
+            return target.set_mode(command.new_mode);
+        }
+        return false;
+    }
+}
@@ -1,146 +1,178 @@
 #include "blinkstick/device.hpp"
+#include "blinkstick/hidapi_transport.hpp"
+#include "blinkstick/log.hpp"
+#include "blinkstick/variant.hpp"
+#include "packing.hpp"
+#include "protocol.hpp"
 
-#include <hidapi/hidapi.h>
-
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <optional>
 
 namespace
 {
-    constexpr int MODE_MSG_SIZE = 2;
-    constexpr int COUNT_MSG_SIZE = 2;
+    std::vector<blinkstick::colour>* find_shadow(
+        std::vector<std::vector<blinkstick::colour>>& shadow_frames,
+        const int channel)
+    {
+        if (channel < 0 || static_cast<size_t>(channel) >= shadow_frames.size() || shadow_frames[channel].empty())
+        {
+            return nullptr;
+        }
+        return &shadow_frames[channel];
+    }
+}
 
-    std::vector<uint8_t> build_control_message(const uint8_t index, const uint8_t channel, uint8_t red, uint8_t green, uint8_t blue)
+namespace blinkstick
+{
+    struct device::state
     {
-        // Write to the first LED present
-        // this will be the _only_ led for the original blinkstick
-        if (index == 0 && channel == 0)
+        std::optional<int> led_count;
+        std::optional<mode> current_mode;
+        bool delta_encoding = false;
+        uint8_t brightness = 255;
+
+        // The correction as given, and the tables actually applied, which fold in the brightness
+        std::optional<colour_correction> correction;
+        colour_correction tables;
+
+        colour output(const colour value) const
         {
-            return
+            if (correction)
             {
-                0x1,
-                red,
-                green,
-                blue
-            };
+                return colour{ tables.red[value.red], tables.green[value.green], tables.blue[value.blue] };
+            }
+            return colour{
+                packing::scale(value.red, brightness),
+                packing::scale(value.green, brightness),
+                packing::scale(value.blue, brightness) };
         }
 
-        // Writing to the other LEDs requires a different payload
-        // this changes the write mode (first two bytes) and then
-        // assigns the index.
-        return
+        void rebuild_tables()
         {
-            0x5,
-            channel,
-            index,
-			red,
-			green,
-			blue
-        };
+            if (!correction)
+            {
+                return;
+            }
+            for (size_t i = 0; i < tables.red.size(); ++i)
+            {
+                tables.red[i] = packing::scale(correction->red[i], brightness);
+                tables.green[i] = packing::scale(correction->green[i], brightness);
+                tables.blue[i] = packing::scale(correction->blue[i], brightness);
+            }
+        }
+        std::vector<std::vector<colour>> shadow_frames;
+        std::vector<uint8_t> report_buffer;
+        std::vector<colour> solid_frame;
+        int retry_limit = 0;
+        device_stats stats;
+    };
+
+    device::device(std::shared_ptr<transport> io, device_type type) :
+        io(std::move(io)),
+        type(type),
+        shared(std::make_shared<state>())
+    {
     }
 
-    constexpr std::array<uint8_t, MODE_MSG_SIZE> build_mode_message(blinkstick::mode mode)
+    device::device(std::shared_ptr<hid_device> handle, device_type type) :
+        device(handle ? std::make_shared<hidapi_transport>(std::move(handle)) : nullptr, type)
     {
-        return
-        {
-            0x0004,
-            static_cast<uint8_t>(mode)
-        };
     }
 
-    constexpr std::array<uint8_t, COUNT_MSG_SIZE> build_count_message(const uint8_t count)
+    device::device(std::nullptr_t, device_type type) :
+        device(std::shared_ptr<transport>(), type)
     {
-        return
-        {
-            0x81,
-            count
-        };
     }
 
-    std::pair<uint8_t, uint8_t> determine_report_id(const int count)
+    bool device::send_report(const uint8_t* data, const size_t size) const
     {
-        uint8_t max_leds = 64;
-        uint8_t report_id = 9;
-
-        if (count <= 8 * 3)
-        {
-            max_leds = 8;
-            report_id = 6;
-        }
-        else if (count <= 16 * 3)
+        if (io == nullptr)
         {
-            max_leds = 16;
-            report_id = 7;
+            return false;
         }
-        else if (count <= 32 * 3)
+        for (int attempt = 0;; ++attempt)
         {
-            max_leds = 32;
-            report_id = 8;
+            const auto start = std::chrono::steady_clock::now();
+            const bool ok = io->send_feature_report(data, size);
+            shared->stats.record_send(data[0], size, std::chrono::steady_clock::now() - start, ok);
+            if (ok || attempt >= shared->retry_limit)
+            {
+                return ok;
+            }
+            shared->stats.record_retry();
         }
-        else if (count <= 64 * 3)
+    }
+
+    bool device::get_report(uint8_t* data, const size_t size) const
+    {
+        if (io == nullptr)
         {
-            max_leds = 64;
-            report_id = 9;
+            return false;
         }
-        else if (count <= 128 * 3)
+        const uint8_t report_id = data[0];
+        for (int attempt = 0;; ++attempt)
         {
-            max_leds = 64;
-            report_id = 10;
+            const auto start = std::chrono::steady_clock::now();
+            const bool ok = io->get_feature_report(data, size);
+            shared->stats.record_get(report_id, size, std::chrono::steady_clock::now() - start, ok);
+            if (ok || attempt >= shared->retry_limit)
+            {
+                return ok;
+            }
+            data[0] = report_id;
+            shared->stats.record_retry();
         }
-
-        return { report_id, max_leds };
     }
 
-    template<typename T>
-    bool get_feature_report(const std::shared_ptr<hid_device>& handle, T& msg)
+    stats_snapshot device::get_stats() const
     {
-        return hid_get_feature_report(handle.get(), msg.data(), msg.size()) != -1;
+        return shared->stats.snapshot();
     }
 
-    template<typename T>
-    bool send_feature_report(const std::shared_ptr<hid_device>& handle, const T& msg)
-    {
-        return hid_send_feature_report(handle.get(), msg.data(), msg.size()) != -1;
-    }
-}
-
-namespace blinkstick
-{
-    void debug(const char* fmt, ...);
-
-    device::device(std::shared_ptr<hid_device> handle, device_type type) :
-        handle(std::move(handle)),
-        type(type)
+    void device::set_retry_limit(const int retries)
     {
+        shared->retry_limit = std::max(retries, 0);
     }
 
     bool device::set_mode(const mode mode) const
     {
-        if (handle == nullptr)
+        if (io == nullptr)
         {
-            debug("input hid handle is null");
+            BLINKSTICK_LOG(log_level::error, "input transport is null");
             return false;
         }
 
-		const auto msg = build_mode_message(mode);
+		const auto msg = protocol::build_mode_message(mode);
 
-        if (!send_feature_report(handle, msg))
+        shared->shadow_frames.clear();
+        shared->current_mode.reset();
+        if (!send_report(msg.data(), msg.size()))
         {
-            debug("error writing mode to device");
+            BLINKSTICK_LOG(log_level::error, "error writing mode to device", log_field("mode", static_cast<int>(mode)));
             return false;
         }
+        shared->current_mode = mode;
         return true;
     }
 
     mode device::get_mode() const
     {
-        auto data = build_mode_message(mode::unknown);
-        if (!send_feature_report(handle, data))
+        if (shared->current_mode)
+        {
+            return *shared->current_mode;
+        }
+
+        auto data = protocol::build_mode_message(mode::unknown);
+        if (!get_report(data.data(), data.size()))
         {
-            debug("error reading mode from device");
+            BLINKSTICK_LOG(log_level::error, "error reading mode from device");
             return mode::unknown;
         }
 
-        return static_cast<mode>(data[1]);
+        shared->current_mode = static_cast<mode>(data[1]);
+        return *shared->current_mode;
     }
 
 
@@ -151,17 +183,27 @@ namespace blinkstick
         const uint8_t green,
         const uint8_t blue) const
     {
-        if (handle == nullptr)
+        if (io == nullptr)
         {
-            debug("input hid handle is null");
+            BLINKSTICK_LOG(log_level::error, "input transport is null");
             return false;
         }
-        const auto msg = build_control_message(index, channel, red, green, blue);
-        if (!send_feature_report(handle, msg))
+        const auto value = shared->output(colour{ red, green, blue });
+        const auto msg = protocol::build_control_message(index, channel, value.red, value.green, value.blue);
+        auto* shadow = find_shadow(shared->shadow_frames, channel);
+        if (!send_report(msg.data(), msg.size()))
         {
-            debug("error writing colour to device");
+            BLINKSTICK_LOG(log_level::error, "error writing colour to device", log_field("channel", channel));
+            if (shadow)
+            {
+                shadow->clear();
+            }
             return false;
         }
+        if (shadow && index >= 0 && static_cast<size_t>(index) < shadow->size())
+        {
+            (*shadow)[index] = colour{ red, green, blue };
+        }
         return true;
     }
 
@@ -171,59 +213,300 @@ namespace blinkstick
         const uint8_t green,
         const uint8_t blue) const
     {
-        std::vector<colour> colours;
-        const auto total_leds = get_led_count();
-        colours.reserve(total_leds);
-        for (int i = 0; i < total_leds; ++i)
-        {
-            colour colour;
-            colour.red = red;
-            colour.green = green;
-            colour.blue = blue;
-            colours.emplace_back(std::move(colour));
-        }
+        const auto total_leds = static_cast<size_t>(get_led_count());
+        // Reused between calls so a solid colour does not allocate once the first frame is sent
+        shared->solid_frame.assign(total_leds, colour{ red, green, blue });
 
-        return set_colours(channel, colours);
+        return set_colours(channel, shared->solid_frame.data(), shared->solid_frame.size());
     }
 
     bool device::set_colours(
-        int channel,
+        const int channel,
         const std::vector<colour>& colours) const
     {
-        if (handle == nullptr)
+        return set_colours(channel, colours.data(), colours.size());
+    }
+
+    bool device::set_colours(
+        const int channel,
+        const colour* colours,
+        const size_t count) const
+    {
+        if (io == nullptr)
         {
-            debug("input hid handle is null");
+            BLINKSTICK_LOG(log_level::error, "input transport is null");
             return false;
         }
 
-        const auto [report_id, max_leds] = determine_report_id(get_led_count() * 3);
+        const int total = get_led_count();
+        if (total <= max_leds_per_channel)
+        {
+            const auto layout = bulk_report_for(total);
+            return set_segment(channel, colours, count, layout.report_id, layout.max_leds);
+        }
 
-        std::vector<uint8_t> msg(static_cast<size_t>(max_leds) * 3 + 2);
+        // A report only carries 64 LEDs, so longer strips continue on the following channels
+        int segments = (total + max_leds_per_channel - 1) / max_leds_per_channel;
+        if (const int available = channel_count(type) - channel; segments > available)
+        {
+            BLINKSTICK_LOG(
+                log_level::warning,
+                "strip is longer than the channels left on the device, truncating",
+                log_field("leds", total),
+                log_field("channel", channel));
+            segments = std::max(available, 0);
+        }
+        if (count > static_cast<size_t>(total))
+        {
+            BLINKSTICK_LOG(
+                log_level::debug,
+                "frame is longer than the strip, truncating",
+                log_field("colours", count),
+                log_field("leds", total));
+        }
+
+        for (int segment = 0; segment < segments; ++segment)
+        {
+            const size_t offset = static_cast<size_t>(segment) * max_leds_per_channel;
+            const auto layout = bulk_report_for(std::min(total - static_cast<int>(offset), max_leds_per_channel));
+            const size_t length = count > offset ? std::min(count - offset, static_cast<size_t>(layout.max_leds)) : 0;
+            if (!set_segment(channel + segment, length ? colours + offset : colours, length, layout.report_id, layout.max_leds))
+            {
+                return false;
+            }
+        }
+        return segments > 0;
+    }
+
+    bool device::set_segment(
+        const int channel,
+        const colour* colours,
+        const size_t count,
+        const uint8_t report_id,
+        const int max_leds) const
+    {
+        const size_t frame_size = max_leds;
+        const auto wanted = [&](const size_t i) { return i < count ? colours[i] : colour{}; };
 
-        msg[0] = report_id;
-        msg[1] = channel;
+        if (auto* sent = find_shadow(shared->shadow_frames, channel);
+            shared->delta_encoding && sent && sent->size() == frame_size)
+        {
+            int changes = 0;
+            for (size_t i = 0; i < frame_size; ++i)
+            {
+                changes += wanted(i) != (*sent)[i];
+            }
+            if (changes == 0)
+            {
+                shared->stats.record_frame();
+                return true;
+            }
+            if (protocol::indexed_is_cheaper(changes, max_leds))
+            {
+                for (size_t i = 0; i < frame_size; ++i)
+                {
+                    const auto colour = wanted(i);
+                    if (colour != (*sent)[i]
+                        && !set_colour(channel, static_cast<int>(i), colour.red, colour.green, colour.blue))
+                    {
+                        return false;
+                    }
+                }
+                shared->stats.record_frame();
+                return true;
+            }
+        }
+
+        shared->report_buffer.resize(static_cast<size_t>(max_leds) * 3 + 2);
+        return send_colours(
+            report_id,
+            channel,
+            colours,
+            count,
+            shared->report_buffer.data(),
+            shared->report_buffer.size());
+    }
 
-        auto colourSize = std::min(static_cast<uint8_t>(colours.size()), max_leds);
+    bool device::send_colours(
+        const uint8_t report_id,
+        const int channel,
+        const colour* colours,
+        const size_t count,
+        uint8_t* report,
+        const size_t report_size) const
+    {
+        if (io == nullptr)
+        {
+            BLINKSTICK_LOG(log_level::error, "input transport is null");
+            return false;
+        }
 
-        int index = 2;
+        if (report_size < 2)
+        {
+            return false;
+        }
+        const size_t frame_size = (report_size - 2) / 3;
+        const size_t packed = std::min(count, frame_size);
 
-        for (int i = 0; i < colourSize; ++i)
+        report[0] = report_id;
+        report[1] = static_cast<uint8_t>(channel);
+        if (shared->correction)
         {
-            const auto& colour = colours[i];
-            msg[index++] = colour.green;
-            msg[index++] = colour.red;
-            msg[index++] = colour.blue;
+            packing::pack_grb(colours, packed, shared->tables, report + 2);
         }
+        else
+        {
+            packing::pack_grb(colours, packed, shared->brightness, report + 2);
+        }
+        std::fill(report + 2 + packed * 3, report + report_size, 0);
 
-        if (!send_feature_report(handle, msg))
+        if (!send_report(report, report_size))
         {
-            debug("error writing colour to device");
+            BLINKSTICK_LOG(log_level::error, "error writing colour to device", log_field("channel", channel));
+            if (auto* sent = find_shadow(shared->shadow_frames, channel))
+            {
+                sent->clear();
+            }
             return false;
         }
+
+        if (channel >= 0)
+        {
+            if (static_cast<size_t>(channel) >= shared->shadow_frames.size())
+            {
+                shared->shadow_frames.resize(static_cast<size_t>(channel) + 1);
+            }
+            auto& shadow = shared->shadow_frames[channel];
+            shadow.resize(frame_size);
+            std::copy(colours, colours + packed, shadow.begin());
+            std::fill(shadow.begin() + packed, shadow.end(), colour{});
+        }
+        shared->stats.record_frame();
         return true;
     }
 
+    void device::set_delta_encoding(const bool enabled)
+    {
+        shared->delta_encoding = enabled;
+    }
+
+    void device::set_brightness(const uint8_t brightness)
+    {
+        if (brightness != shared->brightness)
+        {
+            // The shadow frames hold unscaled colours, so they no longer describe the LEDs
+            shared->shadow_frames.clear();
+            shared->brightness = brightness;
+            shared->rebuild_tables();
+        }
+    }
+
+    uint8_t device::get_brightness() const
+    {
+        return shared->brightness;
+    }
+
+    void device::set_colour_correction(const colour_correction& correction)
+    {
+        shared->shadow_frames.clear();
+        shared->correction = correction;
+        shared->rebuild_tables();
+    }
+
+    void device::clear_colour_correction()
+    {
+        if (shared->correction)
+        {
+            shared->shadow_frames.clear();
+            shared->correction.reset();
+        }
+    }
+
     colour device::get_colour(const int index) const
+    {
+        return get_colour(0, index);
+    }
+
+    colour device::get_colour(const int channel, const int index) const
+    {
+        // Long strips are written 64 LEDs per channel, so look the LED up where set_colours() put it
+        int segment_channel = channel;
+        int offset = index;
+        if (index >= max_leds_per_channel && get_led_count() > max_leds_per_channel)
+        {
+            segment_channel = channel + index / max_leds_per_channel;
+            offset = index % max_leds_per_channel;
+        }
+
+        if (const auto* shadow = find_shadow(shared->shadow_frames, segment_channel);
+            shadow && offset >= 0 && static_cast<size_t>(offset) < shadow->size())
+        {
+            return (*shadow)[offset];
+        }
+        if (segment_channel != 0)
+        {
+            BLINKSTICK_LOG(
+                log_level::debug,
+                "only channel 0 can be read back from the device",
+                log_field("channel", segment_channel),
+                log_field("index", offset));
+            return colour{};
+        }
+        return read_colour(offset);
+    }
+
+    bool device::sync_colours(const int channel) const
+    {
+        if (io == nullptr)
+        {
+            BLINKSTICK_LOG(log_level::error, "input transport is null");
+            return false;
+        }
+        if (channel != 0)
+        {
+            // The bulk reports carry no channel selector, reading one always returns channel 0
+            BLINKSTICK_LOG(log_level::error, "only channel 0 can be read back from the device", log_field("channel", channel));
+            return false;
+        }
+
+        const auto [report_id, max_leds] = protocol::determine_report_id(get_led_count() * 3);
+        shared->report_buffer.reserve(protocol::MAX_REPORT_SIZE);
+        shared->report_buffer.assign(static_cast<size_t>(max_leds) * 3 + 2, 0);
+        shared->report_buffer[0] = report_id;
+
+        if (!get_report(shared->report_buffer.data(), shared->report_buffer.size()))
+        {
+            BLINKSTICK_LOG(log_level::error, "unable to read colours from blinkstick", log_field("channel", channel));
+            if (auto* shadow = find_shadow(shared->shadow_frames, channel))
+            {
+                shadow->clear();
+            }
+            return false;
+        }
+
+        if (static_cast<size_t>(channel) >= shared->shadow_frames.size())
+        {
+            shared->shadow_frames.resize(static_cast<size_t>(channel) + 1);
+        }
+        auto& shadow = shared->shadow_frames[channel];
+        shadow.resize(max_leds);
+        protocol::decode_colours(shared->report_buffer.data() + 2, shadow.size(), shadow.data());
+        return true;
+    }
+
+    std::vector<colour> device::get_colours(const int channel) const
+    {
+        if (!sync_colours(channel))
+        {
+            return {};
+        }
+        // On a long strip this is the first 64 LED segment, the rest lives on the next channels
+        const auto& shadow = shared->shadow_frames[channel];
+        const auto count = std::min(shadow.size(), static_cast<size_t>(get_led_count()));
+        return std::vector<colour>(shadow.begin(), shadow.begin() + count);
+    }
+
+    colour device::read_colour(const int index) const
     {
         colour color;
         color.red = 0;
@@ -235,9 +518,9 @@ namespace blinkstick
             std::array<uint8_t, 33> data;
             data[0] = 0x0001;
 
-            if (!get_feature_report(handle, data))
+            if (!get_report(data.data(), data.size()))
             {
-                debug("unable to read colour from blinkstick");
+                BLINKSTICK_LOG(log_level::error, "unable to read colour from blinkstick", log_field("index", index));
             }
             else
             {
@@ -249,14 +532,21 @@ namespace blinkstick
         else
         {
             const int count = (index + 1) * 3;
-            const auto[report_id, max_leds] = determine_report_id(count);
+            const auto[report_id, max_leds] = protocol::determine_report_id(count);
+            if (index < 0 || index >= max_leds)
+            {
+                BLINKSTICK_LOG(log_level::error, "led index is outside of any colour report", log_field("index", index));
+                return color;
+            }
 
-            std::vector<uint8_t> data(static_cast<size_t>(max_leds) * 3 + 2);
+            shared->report_buffer.reserve(protocol::MAX_REPORT_SIZE);
+            shared->report_buffer.assign(static_cast<size_t>(max_leds) * 3 + 2, 0);
+            auto& data = shared->report_buffer;
             data[0] = report_id;
 
-            if (!get_feature_report(handle, data))
+            if (!get_report(data.data(), data.size()))
             {
-                debug("unable to read colour from blinkstick");
+                BLINKSTICK_LOG(log_level::error, "unable to read colour from blinkstick", log_field("index", index));
             }
             else
             {
@@ -281,33 +571,22 @@ namespace blinkstick
 
     int device::get_led_count() const
     {
-        switch (type)
-        {
-        case device_type::basic:
-            return 1;
-        case device_type::pro:
-            break;
-        case device_type::square:
-        case device_type::strip:
-            return 8;
-        case device_type::nano:
-            return 2;
-        case device_type::flex:
-            break;
-        default:
-            break;
-        };
+        if (const int fixed = fixed_led_count(type); fixed > 0)
+        {
+            return fixed;
+        }
 
+        auto& led_count = shared->led_count;
         if (led_count)
         {
             return *led_count;
         }
         // Build a message with the default value of 0
-        auto data = build_count_message(0);
+        auto data = protocol::build_count_message(0);
 
-        if (!get_feature_report(handle, data))
+        if (!get_report(data.data(), data.size()))
         {
-            debug("error reading mode from device");
+            BLINKSTICK_LOG(log_level::error, "error reading led count from device");
         }
 
         led_count = data[1];
@@ -317,20 +596,21 @@ namespace blinkstick
 
     bool device::set_led_count(const uint8_t count) const
     {
-        if (handle == nullptr)
+        if (io == nullptr)
         {
-            debug("input hid handle is null");
+            BLINKSTICK_LOG(log_level::error, "input transport is null");
             return false;
         }
 
-        const auto msg = build_count_message(count);
+        const auto msg = protocol::build_count_message(count);
 
-        if (!send_feature_report(handle, msg))
+        shared->shadow_frames.clear();
+        if (!send_report(msg.data(), msg.size()))
         {
-            debug("error writing led count to device");
+            BLINKSTICK_LOG(log_level::error, "error writing led count to device", log_field("count", count));
             return false;
         }
-        led_count = count;
+        shared->led_count = count;
         return true;
     }
 
@@ -339,8 +619,13 @@ namespace blinkstick
         return type;
     }
 
+    const void* device::get_id() const
+    {
+        return shared.get();
+    }
+
     bool device::is_valid() const
     {
-        return handle != nullptr;
+        return io != nullptr;
     }
 }
@@ -0,0 +1,160 @@
+#include "blinkstick/dither.hpp"
+#include "packing.hpp"
+
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BLINKSTICK_X86_KERNELS 1
+#endif
+
+// Every channel is quantised the same way, so the kernels treat the framebuffer as one flat run of
+// 16-bit values and the output as the matching run of bytes:
+//   sum = min(value + error, 65535), output = sum >> 8, error = sum & 0xFF
+namespace
+{
+    static_assert(sizeof(blinkstick::colour16) == 6, "16-bit colours are treated as packed triplets");
+
+    using quantise_function = void (*)(const uint16_t*, uint16_t*, uint8_t*, size_t);
+
+    void quantise_scalar(const uint16_t* values, uint16_t* error, uint8_t* out, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto sum = static_cast<uint16_t>(std::min<unsigned>(values[i] + error[i], 0xFFFF));
+            out[i] = static_cast<uint8_t>(sum >> 8);
+            error[i] = sum & 0xFF;
+        }
+    }
+
+#ifdef BLINKSTICK_X86_KERNELS
+    // SSE2 is part of x86-64, so this needs no runtime check there
+    __attribute__((target("sse2"))) void quantise_sse2(
+        const uint16_t* values,
+        uint16_t* error,
+        uint8_t* out,
+        const size_t count)
+    {
+        const __m128i low_byte = _mm_set1_epi16(0xFF);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            const __m128i first = _mm_adds_epu16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(error + i)));
+            const __m128i second = _mm_adds_epu16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + 8)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(error + i + 8)));
+
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(out + i),
+                _mm_packus_epi16(_mm_srli_epi16(first, 8), _mm_srli_epi16(second, 8)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(error + i), _mm_and_si128(first, low_byte));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(error + i + 8), _mm_and_si128(second, low_byte));
+        }
+        quantise_scalar(values + i, error + i, out + i, count - i);
+    }
+
+    __attribute__((target("avx2"))) void quantise_avx2(
+        const uint16_t* values,
+        uint16_t* error,
+        uint8_t* out,
+        const size_t count)
+    {
+        const __m256i low_byte = _mm256_set1_epi16(0xFF);
+        size_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            const __m256i first = _mm256_adds_epu16(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(error + i)));
+            const __m256i second = _mm256_adds_epu16(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + 16)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(error + i + 16)));
+
+            // packus works within 128 bit halves, leaving the quarters in the order 0 2 1 3
+            const __m256i packed = _mm256_packus_epi16(_mm256_srli_epi16(first, 8), _mm256_srli_epi16(second, 8));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permute4x64_epi64(packed, 0xD8));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(error + i), _mm256_and_si256(first, low_byte));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(error + i + 16), _mm256_and_si256(second, low_byte));
+        }
+        quantise_sse2(values + i, error + i, out + i, count - i);
+    }
+#endif
+
+    quantise_function best_quantise()
+    {
+#ifdef BLINKSTICK_X86_KERNELS
+        if (blinkstick::packing::supported(blinkstick::packing::kernel::avx2))
+        {
+            return quantise_avx2;
+        }
+#if defined(__x86_64__) || defined(__SSE2__)
+        return quantise_sse2;
+#endif
+#endif
+        return quantise_scalar;
+    }
+}
+
+namespace blinkstick
+{
+    dithered_framebuffer::dithered_framebuffer(const size_t count) :
+        pixels(count),
+        error(count * 3),
+        output(count)
+    {
+        // Multiplying by an odd constant spreads the starting errors over the whole byte
+        for (size_t i = 0; i < error.size(); ++i)
+        {
+            error[i] = static_cast<uint16_t>((i * 151) & 0xFF);
+        }
+    }
+
+    size_t dithered_framebuffer::size() const
+    {
+        return pixels.size();
+    }
+
+    colour16* dithered_framebuffer::data()
+    {
+        return pixels.data();
+    }
+
+    const colour16* dithered_framebuffer::data() const
+    {
+        return pixels.data();
+    }
+
+    colour16& dithered_framebuffer::operator[](const size_t index)
+    {
+        return pixels[index];
+    }
+
+    const colour16& dithered_framebuffer::operator[](const size_t index) const
+    {
+        return pixels[index];
+    }
+
+    void dithered_framebuffer::fill(const colour16& value)
+    {
+        std::fill(pixels.begin(), pixels.end(), value);
+    }
+
+    const std::vector<colour>& dithered_framebuffer::quantise()
+    {
+        static const quantise_function quantise_values = best_quantise();
+        quantise_values(
+            reinterpret_cast<const uint16_t*>(pixels.data()),
+            error.data(),
+            reinterpret_cast<uint8_t*>(output.data()),
+            error.size());
+        return output;
+    }
+
+    bool dithered_framebuffer::send(const device& target, const int channel)
+    {
+        const auto& frame = quantise();
+        return target.set_colours(channel, frame.data(), frame.size());
+    }
+}
@@ -0,0 +1,351 @@
+#include "blinkstick/effects.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    using blinkstick::colour;
+
+    // One full period in the fixed-point phase used by the periodic effects
+    constexpr int64_t PHASE_ONE = 1 << 16;
+
+    const std::array<uint8_t, 256>& sine_table()
+    {
+        static const auto table = []
+        {
+            std::array<uint8_t, 256> values{};
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                // Starts dark so a pulse fades in from off
+                const double wave = 0.5 - 0.5 * std::cos(2.0 * 3.14159265358979323846 * static_cast<double>(i) / 256.0);
+                values[i] = static_cast<uint8_t>(std::lround(wave * 255.0));
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    // Position within the current period, from 0 up to (but excluding) PHASE_ONE
+    uint32_t phase(const std::chrono::nanoseconds elapsed, const std::chrono::nanoseconds period)
+    {
+        if (period.count() <= 0 || elapsed.count() < 0)
+        {
+            return 0;
+        }
+        return static_cast<uint32_t>((elapsed.count() % period.count()) * PHASE_ONE / period.count());
+    }
+
+    uint8_t scale(const uint8_t value, const uint8_t level)
+    {
+        return static_cast<uint8_t>((value * (level + 1)) >> 8);
+    }
+
+    colour scale(const colour value, const uint8_t level)
+    {
+        return colour{ scale(value.red, level), scale(value.green, level), scale(value.blue, level) };
+    }
+
+    uint8_t blend(const uint8_t from, const uint8_t to, const int amount)
+    {
+        return static_cast<uint8_t>(from + ((to - from) * amount) / 256);
+    }
+
+    // amount runs from 0 (from) to 256 (to)
+    colour blend(const colour from, const colour to, const int amount)
+    {
+        return colour{ blend(from.red, to.red, amount), blend(from.green, to.green, amount), blend(from.blue, to.blue, amount) };
+    }
+}
+
+namespace blinkstick
+{
+    solid_effect::solid_effect(const colour value) :
+        value(value)
+    {
+    }
+
+    void solid_effect::render(std::chrono::nanoseconds, colour* frame, const size_t count)
+    {
+        std::fill(frame, frame + count, value);
+    }
+
+    pulse_effect::pulse_effect(const colour value, const std::chrono::nanoseconds period) :
+        value(value),
+        period(period)
+    {
+    }
+
+    void pulse_effect::render(const std::chrono::nanoseconds elapsed, colour* frame, const size_t count)
+    {
+        const auto level = sine_table()[phase(elapsed, period) >> 8];
+        std::fill(frame, frame + count, scale(value, level));
+    }
+
+    rainbow_effect::rainbow_effect(const std::chrono::nanoseconds period, const uint16_t spread) :
+        period(period),
+        spread(spread)
+    {
+    }
+
+    void rainbow_effect::render(const std::chrono::nanoseconds elapsed, colour* frame, const size_t count)
+    {
+        const auto base = phase(elapsed, period) >> 8;
+        hues.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            hues[i] = hsv{ static_cast<uint8_t>(base + i * spread / count), 255, 255 };
+        }
+        hsv_to_rgb(hues.data(), count, frame);
+    }
+
+    chase_effect::chase_effect(
+        const colour value,
+        const colour background,
+        const std::chrono::nanoseconds period,
+        const size_t length) :
+        value(value),
+        background(background),
+        period(period),
+        length(std::max<size_t>(length, 1))
+    {
+    }
+
+    void chase_effect::render(const std::chrono::nanoseconds elapsed, colour* frame, const size_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        const size_t head = static_cast<size_t>(phase(elapsed, period)) * count / PHASE_ONE;
+        for (size_t i = 0; i < count; ++i)
+        {
+            // LEDs behind the head, wrapping around the end
+            const size_t distance = (head + count - i) % count;
+            frame[i] = distance < length
+                ? blend(background, value, static_cast<int>(256 - distance * 256 / length))
+                : background;
+        }
+    }
+
+    twinkle_effect::twinkle_effect(
+        const colour value,
+        const uint16_t density,
+        const std::chrono::nanoseconds decay,
+        const uint32_t seed) :
+        value(value),
+        density(density),
+        decay(decay),
+        state(seed == 0 ? 1 : seed)
+    {
+    }
+
+    uint32_t twinkle_effect::next_random()
+    {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    void twinkle_effect::render(const std::chrono::nanoseconds elapsed, colour* frame, const size_t count)
+    {
+        levels.resize(count);
+        const auto step = std::max<int64_t>((elapsed - last).count(), 0);
+        last = elapsed;
+
+        // Both in 1/65536ths, scaled to the time since the previous frame
+        const int64_t fade = decay.count() > 0 ? step * 65535 / decay.count() : 65535;
+        const int64_t chance = std::min<int64_t>(density * step / 1000000, 65536);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto level = static_cast<int64_t>(levels[i]) - fade;
+            if (static_cast<int64_t>(next_random() & 0xFFFF) < chance)
+            {
+                level = 65535;
+            }
+            levels[i] = static_cast<uint16_t>(std::max<int64_t>(level, 0));
+            frame[i] = scale(value, static_cast<uint8_t>(levels[i] >> 8));
+        }
+    }
+
+    fade_effect::fade_effect(const colour from, const colour to, const std::chrono::nanoseconds duration) :
+        from(from),
+        to(to),
+        duration(duration)
+    {
+    }
+
+    void fade_effect::render(const std::chrono::nanoseconds elapsed, colour* frame, const size_t count)
+    {
+        int amount = 256;
+        if (duration.count() > 0 && elapsed < duration)
+        {
+            amount = static_cast<int>(std::max<int64_t>(elapsed.count(), 0) * 256 / duration.count());
+        }
+        std::fill(frame, frame + count, blend(from, to, amount));
+    }
+
+    frame_clock::frame_clock(const double fps) :
+        period(std::chrono::nanoseconds(static_cast<int64_t>(1e9 / std::max(fps, 1e-3)))),
+        next(std::chrono::steady_clock::now())
+    {
+    }
+
+    std::chrono::steady_clock::time_point frame_clock::wait()
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now > next + period)
+        {
+            const auto behind = (now - next) / period;
+            skipped += static_cast<uint64_t>(behind);
+            next += behind * period;
+        }
+        std::this_thread::sleep_until(next);
+        const auto tick = next;
+        next += period;
+        return tick;
+    }
+
+    std::chrono::nanoseconds frame_clock::interval() const
+    {
+        return period;
+    }
+
+    uint64_t frame_clock::missed() const
+    {
+        return skipped;
+    }
+
+    effects_engine::~effects_engine()
+    {
+        stop();
+    }
+
+    effects_engine::handle effects_engine::add(
+        device target,
+        const int channel,
+        const size_t led_count,
+        std::shared_ptr<effect> animation)
+    {
+        auto entry = std::make_shared<slot>(slot{ 0, std::move(target), channel, std::move(animation), {}, true, {}, {} });
+        entry->frame.resize(led_count);
+        entry->sent.reserve(led_count);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        const handle id = next_id++;
+        entry->id = id;
+        slots.emplace_back(std::move(entry));
+        return id;
+    }
+
+    bool effects_engine::remove(const handle id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto found = std::find_if(
+            slots.begin(), slots.end(), [id](const std::shared_ptr<slot>& entry) { return entry->id == id; });
+        if (found == slots.end())
+        {
+            return false;
+        }
+        slots.erase(found);
+        return true;
+    }
+
+    size_t effects_engine::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return slots.size();
+    }
+
+    void effects_engine::render(const std::chrono::steady_clock::time_point now)
+    {
+        std::lock_guard<std::mutex> rendering(render_mutex);
+
+        // Only the list is copied under the lock, so add() and remove() never wait for a transfer
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active.assign(slots.begin(), slots.end());
+        }
+
+        ++frames;
+        for (const auto& entry : active)
+        {
+            if (entry->fresh)
+            {
+                entry->started = now;
+                entry->fresh = false;
+            }
+            if (entry->animation)
+            {
+                entry->animation->render(now - entry->started, entry->frame.data(), entry->frame.size());
+            }
+
+            // Static effects such as solid would otherwise cost a full transfer every frame
+            if (entry->frame == entry->sent)
+            {
+                ++unchanged;
+                continue;
+            }
+
+            if (entry->target.set_colours(entry->channel, entry->frame.data(), entry->frame.size()))
+            {
+                // Reuses the capacity reserved in add(), so steady state rendering does not allocate
+                entry->sent = entry->frame;
+                ++submitted;
+            }
+            else
+            {
+                entry->sent.clear();
+                ++failed;
+            }
+        }
+
+        // Entries removed during the frame are released here
+        active.clear();
+    }
+
+    void effects_engine::start(const double fps)
+    {
+        if (worker.joinable())
+        {
+            return;
+        }
+        stopping = false;
+        worker = std::thread(&effects_engine::run, this, fps);
+    }
+
+    void effects_engine::stop()
+    {
+        stopping = true;
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+
+    effects_stats effects_engine::get_stats() const
+    {
+        effects_stats stats;
+        stats.frames = frames;
+        stats.submitted = submitted;
+        stats.unchanged = unchanged;
+        stats.failed = failed;
+        stats.missed = missed;
+        return stats;
+    }
+
+    void effects_engine::run(const double fps)
+    {
+        frame_clock clock(fps);
+        while (!stopping)
+        {
+            render(clock.wait());
+            missed = clock.missed();
+        }
+    }
+}
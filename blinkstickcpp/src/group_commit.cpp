@@ -0,0 +1,173 @@
+#include "blinkstick/group_commit.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace
+{
+    enum class slot_state : int
+    {
+        pending,
+        sent,
+        failed,
+        dropped
+    };
+}
+
+namespace blinkstick
+{
+    struct group_committer::batch
+    {
+        explicit batch(std::vector<device_frame> frames) :
+            frames(std::move(frames)),
+            states(new std::atomic<slot_state>[this->frames.size()])
+        {
+            for (size_t i = 0; i < this->frames.size(); ++i)
+            {
+                states[i] = slot_state::pending;
+            }
+        }
+
+        std::vector<device_frame> frames;
+        std::unique_ptr<std::atomic<slot_state>[]> states;
+        std::atomic<size_t> next{ 0 };
+        std::atomic<bool> cancelled{ false };
+
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t completed = 0;
+    };
+
+    group_committer::group_committer(const size_t workers)
+    {
+        const size_t count = std::max<size_t>(workers, 1);
+        this->workers.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            this->workers.emplace_back(&group_committer::run, this);
+        }
+    }
+
+    group_committer::~group_committer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    commit_result group_committer::commit(
+        std::vector<device_frame> frames,
+        const std::chrono::steady_clock::time_point deadline)
+    {
+        const size_t count = frames.size();
+        auto work = std::make_shared<batch>(std::move(frames));
+
+        if (count > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batches.push_back(work);
+            }
+            wake.notify_all();
+
+            std::unique_lock<std::mutex> lock(work->mutex);
+            if (!work->done.wait_until(lock, deadline, [&] { return work->completed == count; }))
+            {
+                work->cancelled = true;
+            }
+        }
+
+        commit_result result;
+        result.status.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            switch (work->states[i].load())
+            {
+            case slot_state::sent:
+                result.status.push_back(frame_status::sent);
+                ++result.sent;
+                break;
+            case slot_state::failed:
+                result.status.push_back(frame_status::failed);
+                ++result.failed;
+                break;
+            case slot_state::dropped:
+                result.status.push_back(frame_status::dropped);
+                ++result.dropped;
+                break;
+            case slot_state::pending:
+                result.status.push_back(frame_status::timed_out);
+                ++result.timed_out;
+                break;
+            }
+        }
+        return result;
+    }
+
+    void group_committer::run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [this] { return stopping || !batches.empty(); });
+            if (batches.empty())
+            {
+                return;
+            }
+
+            const auto work = batches.front();
+            lock.unlock();
+
+            const size_t index = work->next++;
+            if (index >= work->frames.size())
+            {
+                lock.lock();
+                if (!batches.empty() && batches.front() == work)
+                {
+                    batches.pop_front();
+                }
+                continue;
+            }
+
+            if (!work->cancelled)
+            {
+                const auto& frame = work->frames[index];
+                const auto id = frame.target.get_id();
+
+                lock.lock();
+                const bool claimed = in_flight.insert(id).second;
+                lock.unlock();
+
+                if (claimed)
+                {
+                    const bool sent = frame.target.set_colours(frame.channel, frame.colours);
+                    lock.lock();
+                    in_flight.erase(id);
+                    lock.unlock();
+                    work->states[index] = sent ? slot_state::sent : slot_state::failed;
+                }
+                else
+                {
+                    // A worker from an earlier, timed out commit is still sending to this device
+                    work->states[index] = slot_state::dropped;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> done_lock(work->mutex);
+                if (++work->completed == work->frames.size())
+                {
+                    work->done.notify_all();
+                }
+            }
+            lock.lock();
+        }
+    }
+}
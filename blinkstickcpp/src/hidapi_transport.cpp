@@ -0,0 +1,21 @@
+#include "blinkstick/hidapi_transport.hpp"
+
+#include <hidapi/hidapi.h>
+
+namespace blinkstick
+{
+    hidapi_transport::hidapi_transport(std::shared_ptr<hid_device> handle) :
+        handle(std::move(handle))
+    {
+    }
+
+    bool hidapi_transport::send_feature_report(const uint8_t* data, const size_t size)
+    {
+        return hid_send_feature_report(handle.get(), data, size) != -1;
+    }
+
+    bool hidapi_transport::get_feature_report(uint8_t* data, const size_t size)
+    {
+        return hid_get_feature_report(handle.get(), data, size) != -1;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "blinkstick/device.hpp"
+#include "blinkstick/transport.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Discovery of BlinkSticks through /sys/class/hidraw, shared by the registry and the hotplug monitor
+namespace blinkstick
+{
+    // Where the kernel lists hidraw nodes; a test can point discovery at a canned copy instead
+    constexpr const char* HIDRAW_CLASS_DIR = "/sys/class/hidraw";
+
+    /**
+     * @brief Works out the device type from the serial number and the USB release number.
+     * @details Defined in blinkstick.cpp, shared with hidapi discovery.
+     */
+    device_type get_type(const std::string& serial, uint16_t release_number);
+
+    std::vector<device_info> enumerate_hidraw(const std::string& class_dir = HIDRAW_CLASS_DIR);
+
+    std::shared_ptr<transport> open_hidraw(const std::string& path);
+
+    /**
+     * @brief Fills in info for the hidraw node called name, e.g. hidraw3.
+     * @return false if the node is gone or is not a BlinkStick.
+     */
+    bool describe_hidraw(const std::string& name, device_info& info, const std::string& class_dir = HIDRAW_CLASS_DIR);
+}
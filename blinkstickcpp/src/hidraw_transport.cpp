@@ -0,0 +1,212 @@
+#include "blinkstick/hidraw_transport.hpp"
+#include "blinkstick/device.hpp"
+#include "blinkstick/log.hpp"
+#include "hidraw.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/hidraw.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#endif
+
+namespace
+{
+    constexpr unsigned VENDOR_ID = 0X20A0;
+    constexpr unsigned PRODUCT_ID = 0X41E5;
+
+#ifdef __linux__
+    int system_ioctl(const int fd, const unsigned long request, void* arg)
+    {
+        return ::ioctl(fd, request, arg);
+    }
+
+    struct hidraw_node
+    {
+        std::string path;
+        std::string serial;
+        uint16_t release_number = 0;
+    };
+
+    std::string read_attribute(const std::filesystem::path& path)
+    {
+        std::ifstream file(path);
+        std::string value;
+        std::getline(file, value);
+        return value;
+    }
+
+    // Parses a hidraw node's sysfs entry, which looks like:
+    //   HID_ID=0003:000020A0:000041E5
+    //   HID_UNIQ=BS000001-3.0
+    bool parse_uevent(const std::filesystem::path& class_dir, hidraw_node& node)
+    {
+        std::ifstream uevent(class_dir / "device" / "uevent");
+        if (!uevent)
+        {
+            return false;
+        }
+
+        bool matches = false;
+        std::string line;
+        while (std::getline(uevent, line))
+        {
+            if (line.rfind("HID_ID=", 0) == 0)
+            {
+                unsigned bus = 0;
+                unsigned vendor = 0;
+                unsigned product = 0;
+                if (std::sscanf(line.c_str(), "HID_ID=%x:%x:%x", &bus, &vendor, &product) == 3)
+                {
+                    matches = vendor == VENDOR_ID && product == PRODUCT_ID;
+                }
+            }
+            else if (line.rfind("HID_UNIQ=", 0) == 0)
+            {
+                node.serial = line.substr(9);
+            }
+        }
+
+        // hid device -> usb interface -> usb device, which carries bcdDevice
+        const auto bcd = read_attribute(class_dir / "device" / ".." / ".." / "bcdDevice");
+        if (!bcd.empty())
+        {
+            node.release_number = static_cast<uint16_t>(std::strtoul(bcd.c_str(), nullptr, 16));
+        }
+        return matches;
+    }
+
+    std::vector<hidraw_node> enumerate_nodes(const std::string& class_dir)
+    {
+        std::vector<hidraw_node> nodes;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(class_dir, error))
+        {
+            hidraw_node node;
+            if (parse_uevent(entry.path(), node))
+            {
+                node.path = "/dev/" + entry.path().filename().string();
+                nodes.emplace_back(std::move(node));
+            }
+        }
+        return nodes;
+    }
+#endif
+}
+
+namespace blinkstick
+{
+#ifdef __linux__
+    hidraw_transport::hidraw_transport(const int fd, const ioctl_function control) :
+        fd(fd),
+        control(control ? control : system_ioctl)
+    {
+    }
+
+    hidraw_transport::~hidraw_transport()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+
+    std::shared_ptr<hidraw_transport> hidraw_transport::open(const std::string& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+        return std::make_shared<hidraw_transport>(fd);
+    }
+
+    bool hidraw_transport::send_feature_report(const uint8_t* data, const size_t size)
+    {
+        // The ioctl only reads from the buffer despite taking a non-const pointer
+        return control(fd, HIDIOCSFEATURE(size), const_cast<uint8_t*>(data)) >= 0;
+    }
+
+    bool hidraw_transport::get_feature_report(uint8_t* data, const size_t size)
+    {
+        return control(fd, HIDIOCGFEATURE(size), data) >= 0;
+    }
+
+    std::vector<device_info> enumerate_hidraw(const std::string& class_dir)
+    {
+        std::vector<device_info> devices;
+        for (auto& node : enumerate_nodes(class_dir))
+        {
+            BLINKSTICK_LOG(log_level::debug, "found device", log_field("path", node.path), log_field("serial", node.serial));
+            const auto type = get_type(node.serial, node.release_number);
+            devices.push_back(device_info{ std::move(node.path), std::move(node.serial), type });
+        }
+        return devices;
+    }
+
+    std::shared_ptr<transport> open_hidraw(const std::string& path)
+    {
+        return hidraw_transport::open(path);
+    }
+
+    bool describe_hidraw(const std::string& name, device_info& info, const std::string& class_dir)
+    {
+        hidraw_node node;
+        if (!parse_uevent(std::filesystem::path(class_dir) / name, node))
+        {
+            return false;
+        }
+        info.path = "/dev/" + name;
+        info.serial = std::move(node.serial);
+        info.type = get_type(info.serial, node.release_number);
+        return true;
+    }
+#else
+    hidraw_transport::hidraw_transport(const int fd, const ioctl_function control) :
+        fd(fd),
+        control(control)
+    {
+    }
+
+    hidraw_transport::~hidraw_transport() = default;
+
+    std::shared_ptr<hidraw_transport> hidraw_transport::open(const std::string&)
+    {
+        return nullptr;
+    }
+
+    bool hidraw_transport::send_feature_report(const uint8_t*, size_t)
+    {
+        return false;
+    }
+
+    bool hidraw_transport::get_feature_report(uint8_t*, size_t)
+    {
+        return false;
+    }
+
+    std::vector<device_info> enumerate_hidraw(const std::string&)
+    {
+        BLINKSTICK_LOG(log_level::warning, "hidraw is only available on Linux");
+        return {};
+    }
+
+    std::shared_ptr<transport> open_hidraw(const std::string&)
+    {
+        return nullptr;
+    }
+
+    bool describe_hidraw(const std::string&, device_info&, const std::string&)
+    {
+        return false;
+    }
+#endif
+}
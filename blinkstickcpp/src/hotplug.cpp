@@ -0,0 +1,334 @@
+#include "blinkstick/hotplug.hpp"
+#include "hidraw.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Every BlinkStick hid device lives at .../<bus>:20A0:41E5.<instance>/hidraw/hidrawN
+    bool is_blinkstick(const std::string& devpath)
+    {
+        constexpr std::string_view id = ":20A0:41E5.";
+        const auto same = [](const unsigned char lhs, const unsigned char rhs) { return std::toupper(lhs) == rhs; };
+        return std::search(devpath.begin(), devpath.end(), id.begin(), id.end(), same) != devpath.end();
+    }
+
+    std::string strip_dev_prefix(const std::string& devname)
+    {
+        constexpr const char* prefix = "/dev/";
+        return devname.rfind(prefix, 0) == 0 ? devname.substr(std::strlen(prefix)) : devname;
+    }
+
+    // Header udev puts in front of the properties of the events it re-broadcasts
+    struct udev_header
+    {
+        char prefix[8];
+        unsigned magic;
+        unsigned header_size;
+        unsigned properties_off;
+        unsigned properties_len;
+    };
+
+    // libudev stores its 0xfeedcafe magic in network byte order
+    bool has_udev_magic(const udev_header& header)
+    {
+        std::array<unsigned char, sizeof(header.magic)> bytes;
+        std::memcpy(bytes.data(), &header.magic, bytes.size());
+        return bytes == std::array<unsigned char, 4>{ 0xfe, 0xed, 0xca, 0xfe };
+    }
+}
+
+namespace blinkstick
+{
+#ifdef __linux__
+    netlink_uevent_source::netlink_uevent_source(const group group) :
+        fd(::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT))
+    {
+        if (fd < 0)
+        {
+            return;
+        }
+
+        // Credentials let receive() drop events that did not come from the kernel or udev
+        const int pass_credentials = 1;
+        sockaddr_nl address{};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = static_cast<unsigned>(group);
+        if (::setsockopt(fd, SOL_SOCKET, SO_PASSCRED, &pass_credentials, sizeof(pass_credentials)) != 0
+            || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    netlink_uevent_source::~netlink_uevent_source()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+
+    std::optional<uevent> netlink_uevent_source::receive(const std::chrono::milliseconds timeout)
+    {
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+
+        pollfd waiting{ fd, POLLIN, 0 };
+        if (::poll(&waiting, 1, static_cast<int>(timeout.count())) <= 0)
+        {
+            return std::nullopt;
+        }
+
+        std::array<char, 8192> buffer;
+        iovec data{ buffer.data(), buffer.size() };
+        sockaddr_nl sender{};
+        alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(ucred))> control;
+        msghdr message{};
+        message.msg_name = &sender;
+        message.msg_namelen = sizeof(sender);
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control.data();
+        message.msg_controllen = control.size();
+
+        const auto size = ::recvmsg(fd, &message, MSG_DONTWAIT);
+        if (size <= 0)
+        {
+            return std::nullopt;
+        }
+
+        // Like libudev, only trust multicasts sent by root, and kernel events sent by the kernel itself
+        const auto* header = CMSG_FIRSTHDR(&message);
+        if (header == nullptr || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_CREDENTIALS)
+        {
+            return std::nullopt;
+        }
+        ucred credentials;
+        std::memcpy(&credentials, CMSG_DATA(header), sizeof(credentials));
+        if (credentials.uid != 0 || sender.nl_groups == 0)
+        {
+            return std::nullopt;
+        }
+        if (sender.nl_groups == static_cast<unsigned>(group::kernel) && (sender.nl_pid != 0 || credentials.pid != 0))
+        {
+            return std::nullopt;
+        }
+        return parse(buffer.data(), static_cast<size_t>(size));
+    }
+#else
+    netlink_uevent_source::netlink_uevent_source(group) :
+        fd(-1)
+    {
+    }
+
+    netlink_uevent_source::~netlink_uevent_source() = default;
+
+    std::optional<uevent> netlink_uevent_source::receive(const std::chrono::milliseconds timeout)
+    {
+        std::this_thread::sleep_for(timeout);
+        return std::nullopt;
+    }
+#endif
+
+    bool netlink_uevent_source::is_valid() const
+    {
+        return fd >= 0;
+    }
+
+    std::optional<uevent> netlink_uevent_source::parse(const char* data, const size_t size)
+    {
+        // Kernel messages are "action@devpath\0KEY=value\0...", udev messages start with a
+        // binary header that says where the KEY=value list is
+        size_t offset = 0;
+        if (size >= sizeof(udev_header) && std::memcmp(data, "libudev", 8) == 0)
+        {
+            udev_header header;
+            std::memcpy(&header, data, sizeof(header));
+            if (!has_udev_magic(header) || header.properties_off >= size)
+            {
+                return std::nullopt;
+            }
+            offset = header.properties_off;
+        }
+        else
+        {
+            const auto* end = static_cast<const char*>(std::memchr(data, '\0', size));
+            if (end == nullptr || std::memchr(data, '@', static_cast<size_t>(end - data)) == nullptr)
+            {
+                return std::nullopt;
+            }
+            offset = static_cast<size_t>(end - data) + 1;
+        }
+
+        uevent event;
+        while (offset < size)
+        {
+            const auto* start = data + offset;
+            const auto length = strnlen(start, size - offset);
+            const std::string property(start, length);
+            offset += length + 1;
+
+            const auto equals = property.find('=');
+            if (equals == std::string::npos)
+            {
+                continue;
+            }
+            const auto key = property.substr(0, equals);
+            auto value = property.substr(equals + 1);
+            if (key == "ACTION")
+            {
+                event.action = std::move(value);
+            }
+            else if (key == "DEVPATH")
+            {
+                event.devpath = std::move(value);
+            }
+            else if (key == "SUBSYSTEM")
+            {
+                event.subsystem = std::move(value);
+            }
+            else if (key == "DEVNAME")
+            {
+                event.devname = strip_dev_prefix(value);
+            }
+        }
+
+        if (event.action.empty())
+        {
+            return std::nullopt;
+        }
+        return event;
+    }
+
+    hotplug_monitor::hotplug_monitor(registry& devices, std::unique_ptr<uevent_source> source) :
+        devices(devices),
+        source(std::move(source)),
+        worker(&hotplug_monitor::run, this)
+    {
+    }
+
+    hotplug_monitor::~hotplug_monitor()
+    {
+        stopping = true;
+        worker.join();
+    }
+
+    int hotplug_monitor::subscribe(callback callback)
+    {
+        std::lock_guard<std::mutex> lock(subscribers_mutex);
+        const int id = next_id++;
+        subscribers.emplace(id, std::move(callback));
+        return id;
+    }
+
+    void hotplug_monitor::unsubscribe(const int id)
+    {
+        std::lock_guard<std::mutex> lock(subscribers_mutex);
+        subscribers.erase(id);
+    }
+
+    void hotplug_monitor::handle(const uevent& event)
+    {
+        // Most events are for other subsystems or are change/bind events, so check the cheap
+        // fields first and only then look at the device path
+        const bool added = event.action == "add";
+        if (event.subsystem != "hidraw" || (!added && event.action != "remove"))
+        {
+            return;
+        }
+        if (event.devname.empty() || !is_blinkstick(event.devpath))
+        {
+            return;
+        }
+
+        if (devices.get_backend() == backend::hidraw)
+        {
+            if (added)
+            {
+                device_info info;
+                if (describe_hidraw(event.devname, info) && devices.add(info))
+                {
+                    notify(hotplug_event{ hotplug_event::kind::added, std::move(info) });
+                }
+            }
+            else if (auto info = devices.remove("/dev/" + event.devname))
+            {
+                notify(hotplug_event{ hotplug_event::kind::removed, std::move(*info) });
+            }
+            return;
+        }
+
+        // Other backends name devices in ways a hidraw event does not carry, so enumerate
+        // once and report the difference
+        const auto previous = devices.entries();
+        std::set<std::string> before;
+        for (const auto& info : previous)
+        {
+            before.insert(info.path);
+        }
+        devices.refresh();
+        const auto current = devices.entries();
+
+        for (const auto& info : current)
+        {
+            if (before.erase(info.path) == 0)
+            {
+                notify(hotplug_event{ hotplug_event::kind::added, info });
+            }
+        }
+        for (const auto& info : previous)
+        {
+            if (before.count(info.path) != 0)
+            {
+                notify(hotplug_event{ hotplug_event::kind::removed, info });
+            }
+        }
+    }
+
+    void hotplug_monitor::run()
+    {
+        while (!stopping)
+        {
+            if (const auto event = source->receive(std::chrono::milliseconds(100)))
+            {
+                handle(*event);
+            }
+        }
+    }
+
+    void hotplug_monitor::notify(const hotplug_event& event)
+    {
+        // Call outside the lock so a callback can subscribe or unsubscribe
+        std::vector<callback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(subscribers_mutex);
+            callbacks.reserve(subscribers.size());
+            for (const auto& [id, subscriber] : subscribers)
+            {
+                callbacks.push_back(subscriber);
+            }
+        }
+        for (const auto& subscriber : callbacks)
+        {
+            subscriber(event);
+        }
+    }
+}
@@ -0,0 +1,369 @@
+#include "blinkstick/log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace
+{
+    using blinkstick::log_level;
+    using blinkstick::log_record;
+
+    constexpr size_t RING_SIZE = 1024;
+    static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "the ring size must be a power of two");
+
+    const char* level_name(const log_level level)
+    {
+        switch (level)
+        {
+        case log_level::trace:
+            return "TRACE";
+        case log_level::debug:
+            return "DEBUG";
+        case log_level::info:
+            return "INFO";
+        case log_level::warning:
+            return "WARNING";
+        case log_level::error:
+            return "ERROR";
+        case log_level::off:
+            break;
+        }
+        return "OFF";
+    }
+
+    void print_record(const log_record& record)
+    {
+        std::puts(blinkstick::format_log_record(record).c_str());
+    }
+
+    // Bounded multi-producer ring after Dmitry Vyukov's MPMC queue. Each cell carries a sequence
+    // number telling producers and the consumer whose turn it is, so neither side ever locks.
+    class log_ring
+    {
+    public:
+        log_ring()
+        {
+            for (size_t i = 0; i < RING_SIZE; ++i)
+            {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool push(const log_record& record)
+        {
+            size_t position = enqueue_position.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto& cell = cells[position & (RING_SIZE - 1)];
+                const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+                if (difference == 0)
+                {
+                    if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        cell.record = record;
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    // The consumer has not freed this cell yet: the ring is full
+                    return false;
+                }
+                else
+                {
+                    position = enqueue_position.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Only ever called from the logging thread
+        bool pop(log_record& record)
+        {
+            auto& cell = cells[dequeue_position & (RING_SIZE - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence != dequeue_position + 1)
+            {
+                return false;
+            }
+            record = cell.record;
+            cell.sequence.store(dequeue_position + RING_SIZE, std::memory_order_release);
+            ++dequeue_position;
+            return true;
+        }
+
+        // Whether pop() would return a record. Only ever called from the logging thread
+        bool ready() const
+        {
+            const auto& cell = cells[dequeue_position & (RING_SIZE - 1)];
+            return cell.sequence.load(std::memory_order_acquire) == dequeue_position + 1;
+        }
+
+        size_t pushed() const
+        {
+            return enqueue_position.load(std::memory_order_acquire);
+        }
+
+    private:
+        struct cell
+        {
+            std::atomic<size_t> sequence;
+            log_record record;
+        };
+
+        std::array<cell, RING_SIZE> cells;
+        alignas(64) std::atomic<size_t> enqueue_position{ 0 };
+        alignas(64) size_t dequeue_position = 0;
+    };
+
+    class logger
+    {
+    public:
+        using sink_function = std::function<void(const log_record&)>;
+
+        logger() :
+            worker(&logger::run, this)
+        {
+        }
+
+        ~logger()
+        {
+            stopping = true;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+            }
+            wake.notify_one();
+            worker.join();
+        }
+
+        void write(const log_record& record)
+        {
+            if (!ring.push(record))
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            // Only take the lock when the logging thread is asleep. The fence pairs with the one in
+            // run(), so either this thread sees it sleeping or it sees the record
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed))
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                wake.notify_one();
+            }
+        }
+
+        void set_sink(std::function<void(const log_record&)> replacement)
+        {
+            auto next = std::make_shared<const sink_function>(replacement ? std::move(replacement) : print_record);
+            {
+                std::lock_guard<std::mutex> lock(sink_mutex);
+                sink.swap(next);
+            }
+            // The previous sink is released here, outside the lock, or by drain() if it is still running
+        }
+
+        void flush()
+        {
+            // A sink calling flush_log() would otherwise wait for the record it is handling
+            if (std::this_thread::get_id() == worker.get_id())
+            {
+                return;
+            }
+            const size_t target = ring.pushed();
+            std::unique_lock<std::mutex> lock(mutex);
+            ++flushing;
+            drained.wait(lock, [&] { return delivered.load() >= target; });
+            --flushing;
+        }
+
+        uint64_t dropped_records() const
+        {
+            return dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // Delivers everything queued so far
+        void drain()
+        {
+            log_record record;
+            while (ring.pop(record))
+            {
+                // Called outside the lock, so a sink may log, flush or replace itself
+                const auto current = current_sink();
+                (*current)(record);
+                ++delivered;
+            }
+
+            // Either flush() sees the new count or this sees it waiting
+            if (flushing > 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                drained.notify_all();
+            }
+        }
+
+        std::shared_ptr<const sink_function> current_sink()
+        {
+            std::lock_guard<std::mutex> lock(sink_mutex);
+            return sink;
+        }
+
+        void run()
+        {
+            while (true)
+            {
+                drain();
+
+                std::unique_lock<std::mutex> lock(mutex);
+                if (stopping)
+                {
+                    break;
+                }
+
+                sleeping = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!ring.ready() && !stopping)
+                {
+                    // The timeout only bounds the damage should a wake-up ever be missed
+                    wake.wait_for(lock, std::chrono::milliseconds(100));
+                }
+                sleeping = false;
+            }
+            drain();
+        }
+
+        log_ring ring;
+        std::mutex sink_mutex;
+        std::shared_ptr<const sink_function> sink = std::make_shared<const sink_function>(print_record);
+        std::atomic<size_t> delivered{ 0 };
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<int> flushing{ 0 };
+        std::atomic<bool> sleeping{ false };
+        std::atomic<bool> stopping{ false };
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable drained;
+        std::thread worker;
+    };
+
+    // Started by the first record, so programs that never log never pay for the thread
+    logger& instance()
+    {
+        static logger log;
+        return log;
+    }
+
+    void copy_text(std::array<char, blinkstick::log_field::max_text + 1>& text, const char* value, const size_t length)
+    {
+        const size_t copied = std::min(length, blinkstick::log_field::max_text);
+        std::memcpy(text.data(), value, copied);
+        text[copied] = '\0';
+    }
+}
+
+namespace blinkstick
+{
+    namespace detail
+    {
+        std::atomic<int> log_threshold{ static_cast<int>(log_level::off) };
+
+        void log_write(log_record& record)
+        {
+            record.time = std::chrono::system_clock::now();
+            instance().write(record);
+        }
+    }
+
+    log_field::log_field(const char* key, const char* value) :
+        key(key),
+        type(kind::text)
+    {
+        if (value)
+        {
+            copy_text(text, value, std::strlen(value));
+        }
+    }
+
+    log_field::log_field(const char* key, const std::string& value) :
+        key(key),
+        type(kind::text)
+    {
+        copy_text(text, value.data(), value.size());
+    }
+
+    void set_log_level(const log_level level)
+    {
+        detail::log_threshold.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    log_level get_log_level()
+    {
+        return static_cast<log_level>(detail::log_threshold.load(std::memory_order_relaxed));
+    }
+
+    void set_log_sink(std::function<void(const log_record&)> sink)
+    {
+        instance().set_sink(std::move(sink));
+    }
+
+    std::string format_log_record(const log_record& record)
+    {
+        const auto time = std::chrono::system_clock::to_time_t(record.time);
+        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            record.time.time_since_epoch()).count() % 1000000;
+        std::tm parts{};
+#ifdef _WIN32
+        gmtime_s(&parts, &time);
+#else
+        gmtime_r(&time, &parts);
+#endif
+        char stamp[32];
+        const size_t length = std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &parts);
+        std::snprintf(stamp + length, sizeof(stamp) - length, ".%06lldZ", static_cast<long long>(micros));
+
+        std::string line = stamp;
+        line += ' ';
+        line += level_name(record.level);
+        line += ' ';
+        line += record.message ? record.message : "";
+        for (size_t i = 0; i < std::min(record.field_count, log_record::max_fields); ++i)
+        {
+            const auto& field = record.fields[i];
+            line += ' ';
+            line += field.key ? field.key : "?";
+            line += '=';
+            if (field.type == log_field::kind::integer)
+            {
+                line += std::to_string(field.integer);
+            }
+            else
+            {
+                line += field.text.data();
+            }
+        }
+        return line;
+    }
+
+    void flush_log()
+    {
+        instance().flush();
+    }
+
+    uint64_t dropped_log_records()
+    {
+        return instance().dropped_records();
+    }
+}
@@ -0,0 +1,252 @@
+#include "blinkstick/metrics.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define BLINKSTICK_HAS_FSYNC 1
+#endif
+
+namespace
+{
+    std::string escape_label(const std::string& value)
+    {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (const char c : value)
+        {
+            switch (c)
+            {
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            default:
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+#ifdef BLINKSTICK_HAS_FSYNC
+    bool write_and_sync(const std::string& path, const std::string& contents)
+    {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return false;
+        }
+        const char* data = contents.data();
+        size_t remaining = contents.size();
+        while (remaining > 0)
+        {
+            const ssize_t written = ::write(fd, data, remaining);
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (written <= 0)
+            {
+                ::close(fd);
+                return false;
+            }
+            data += written;
+            remaining -= static_cast<size_t>(written);
+        }
+        // Without this a crash after the rename can leave the new name pointing at an empty file
+        const bool synced = ::fsync(fd) == 0;
+        return ::close(fd) == 0 && synced;
+    }
+
+    bool sync_directory_of(const std::string& path)
+    {
+        const auto slash = path.find_last_of('/');
+        const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        const bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+        return synced;
+    }
+#else
+    bool write_and_sync(const std::string& path, const std::string& contents)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        return file.write(contents.data(), static_cast<std::streamsize>(contents.size())) && file.flush();
+    }
+
+    bool sync_directory_of(const std::string&)
+    {
+        return true;
+    }
+#endif
+
+    double seconds(const std::chrono::nanoseconds value)
+    {
+        return std::chrono::duration<double>(value).count();
+    }
+
+    struct sample
+    {
+        std::string labels;
+        blinkstick::stats_snapshot stats;
+        const blinkstick::async_writer* writer;
+    };
+
+    void write_counter(
+        std::ostringstream& out,
+        const char* name,
+        const char* help,
+        const std::vector<sample>& samples,
+        uint64_t (*value)(const sample&))
+    {
+        out << "# TYPE " << name << " counter\n";
+        out << "# HELP " << name << ' ' << help << '\n';
+        for (const auto& item : samples)
+        {
+            out << name << "_total{" << item.labels << "} " << value(item) << '\n';
+        }
+    }
+
+    void write_latency(
+        std::ostringstream& out,
+        const std::vector<sample>& samples,
+        const char* direction,
+        blinkstick::histogram_snapshot blinkstick::stats_snapshot::*histogram)
+    {
+        for (const auto& item : samples)
+        {
+            const auto& latency = item.stats.*histogram;
+            const auto labels = item.labels + ",direction=\"" + direction + "\"";
+            for (const double quantile : { 0.5, 0.99 })
+            {
+                out << "blinkstick_transfer_latency_seconds{" << labels << ",quantile=\"" << quantile << "\"} "
+                    << seconds(latency.percentile(quantile)) << '\n';
+            }
+            out << "blinkstick_transfer_latency_seconds_sum{" << labels << "} "
+                << seconds(std::chrono::nanoseconds(latency.total_ns)) << '\n';
+            out << "blinkstick_transfer_latency_seconds_count{" << labels << "} " << latency.count << '\n';
+        }
+    }
+}
+
+namespace blinkstick
+{
+    std::string render_openmetrics(const std::vector<metrics_source>& sources)
+    {
+        std::vector<sample> samples;
+        samples.reserve(sources.size());
+        for (const auto& source : sources)
+        {
+            samples.push_back(sample{
+                "device=\"" + escape_label(source.name) + "\"",
+                source.target.get_stats(),
+                source.writer });
+        }
+
+        std::ostringstream out;
+        write_counter(out, "blinkstick_frames", "Frames written to the device.", samples,
+            [](const sample& item) { return item.stats.frames; });
+        write_counter(out, "blinkstick_sent_bytes", "Feature report bytes sent to the device.", samples,
+            [](const sample& item) { return item.stats.bytes_sent; });
+        write_counter(out, "blinkstick_read_bytes", "Feature report bytes read from the device.", samples,
+            [](const sample& item) { return item.stats.bytes_read; });
+        write_counter(out, "blinkstick_errors", "Failed feature report transfers.", samples,
+            [](const sample& item) { return item.stats.errors; });
+        write_counter(out, "blinkstick_retries", "Retried feature report transfers.", samples,
+            [](const sample& item) { return item.stats.retries; });
+        write_counter(out, "blinkstick_dropped_frames", "Frames replaced by a newer frame before being sent.", samples,
+            [](const sample& item) { return item.writer ? item.writer->get_stats().dropped : uint64_t{ 0 }; });
+
+        out << "# TYPE blinkstick_transfer_latency_seconds summary\n";
+        out << "# HELP blinkstick_transfer_latency_seconds Time taken by a single feature report transfer.\n";
+        write_latency(out, samples, "send", &stats_snapshot::send_latency);
+        write_latency(out, samples, "get", &stats_snapshot::get_latency);
+
+        out << "# EOF\n";
+        return out.str();
+    }
+
+    bool write_file_atomically(const std::string& path, const std::string& contents)
+    {
+        const auto temporary = path + ".tmp";
+        if (!write_and_sync(temporary, contents))
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        // rename() replaces the destination in one step on POSIX file systems, and syncing the
+        // directory afterwards makes the new name itself durable
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return sync_directory_of(path);
+    }
+
+    metrics_file_exporter::metrics_file_exporter(
+        std::string path,
+        const std::chrono::milliseconds interval,
+        std::vector<metrics_source> sources) :
+        path(std::move(path)),
+        interval(interval),
+        sources(std::move(sources)),
+        worker(&metrics_file_exporter::run, this)
+    {
+    }
+
+    metrics_file_exporter::~metrics_file_exporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+        write_now();
+    }
+
+    void metrics_file_exporter::set_sources(std::vector<metrics_source> sources)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->sources = std::move(sources);
+    }
+
+    bool metrics_file_exporter::write_now()
+    {
+        std::vector<metrics_source> current;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = sources;
+        }
+        return write_file_atomically(path, render_openmetrics(current));
+    }
+
+    void metrics_file_exporter::run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping)
+        {
+            if (wake.wait_for(lock, interval, [this] { return stopping; }))
+            {
+                break;
+            }
+            lock.unlock();
+            write_now();
+            lock.lock();
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace blinkstick
+{
+    /**
+     * @brief Bounded multi-producer single-consumer ring of preallocated cells (Dmitry Vyukov's design).
+     * @details Producers claim a cell with a single compare-and-swap and fill it in place, so a push
+     * never allocates and producers never block each other. Cells keep whatever their values
+     * own between uses, for example a vector's capacity. front(), pop() and idle() may only be
+     * called from the consumer thread.
+     */
+    template<typename T, size_t Capacity>
+    class mpsc_ring
+    {
+        static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        mpsc_ring()
+        {
+            for (size_t i = 0; i < Capacity; ++i)
+            {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        mpsc_ring(const mpsc_ring&) = delete;
+        mpsc_ring& operator=(const mpsc_ring&) = delete;
+
+        /**
+         * @brief Claims the next free cell, calls fill on its value and publishes it.
+         * @return false if every cell is in use.
+         */
+        template<typename Fill>
+        bool try_push(Fill&& fill)
+        {
+            size_t position = head.load(std::memory_order_relaxed);
+            while (true)
+            {
+                cell& target = cells[position & (Capacity - 1)];
+                const size_t sequence = target.sequence.load(std::memory_order_acquire);
+                if (sequence == position)
+                {
+                    // seq_cst rather than relaxed so a consumer that checks idle() after announcing
+                    // it is about to sleep is guaranteed to either see this claim or be seen by the producer
+                    if (head.compare_exchange_weak(position, position + 1, std::memory_order_seq_cst))
+                    {
+                        fill(target.value);
+                        target.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (sequence < position)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @return the oldest value, or nullptr if the ring is empty or its oldest push is half way done.
+         */
+        T* front()
+        {
+            cell& target = cells[tail & (Capacity - 1)];
+            if (target.sequence.load(std::memory_order_acquire) != tail + 1)
+            {
+                return nullptr;
+            }
+            return &target.value;
+        }
+
+        /**
+         * @brief Hands the cell returned by front() back to the producers.
+         */
+        void pop()
+        {
+            cells[tail & (Capacity - 1)].sequence.store(tail + Capacity, std::memory_order_release);
+            ++tail;
+        }
+
+        /**
+         * @brief Whether nothing has been claimed since the last value was popped, including pushes
+         * that are still in progress.
+         */
+        bool idle() const
+        {
+            return head.load() == tail;
+        }
+
+    private:
+        struct cell
+        {
+            std::atomic<size_t> sequence{ 0 };
+            T value;
+        };
+
+        std::array<cell, Capacity> cells;
+        std::atomic<size_t> head{ 0 };
+        size_t tail = 0;
+    };
+}
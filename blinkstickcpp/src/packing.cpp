@@ -0,0 +1,184 @@
+#include "packing.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BLINKSTICK_X86_KERNELS 1
+#endif
+
+namespace
+{
+    using blinkstick::colour;
+    using blinkstick::packing::kernel;
+    using blinkstick::packing::scale;
+
+    using pack_function = void (*)(const colour*, size_t, uint8_t, uint8_t*);
+
+    void pack_scalar(const colour* colours, const size_t count, const uint8_t brightness, uint8_t* out)
+    {
+        if (brightness == 255)
+        {
+            for (size_t i = 0; i < count; ++i, out += 3)
+            {
+                out[0] = colours[i].green;
+                out[1] = colours[i].red;
+                out[2] = colours[i].blue;
+            }
+            return;
+        }
+        for (size_t i = 0; i < count; ++i, out += 3)
+        {
+            out[0] = scale(colours[i].green, brightness);
+            out[1] = scale(colours[i].red, brightness);
+            out[2] = scale(colours[i].blue, brightness);
+        }
+    }
+
+#ifdef BLINKSTICK_X86_KERNELS
+    // The kernels work on 5 LEDs per 16 byte register: the first 15 bytes are swapped from RGB to
+    // GRB and the 16th is garbage that the next store, or the scalar tail, overwrites. That keeps
+    // every triplet inside one register, at the cost of needing 16 readable and writable bytes
+    // wherever 15 are used.
+    constexpr size_t LEDS_PER_LANE = 5;
+    constexpr size_t LANE_BYTES = LEDS_PER_LANE * 3;
+
+    __attribute__((target("ssse3"))) inline __m128i scale_lane(const __m128i bytes, const __m128i factor)
+    {
+        // (value * (brightness + 1)) >> 8 on 16 bit halves, matching the scalar scale()
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i low = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(bytes, zero), factor), 8);
+        const __m128i high = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(bytes, zero), factor), 8);
+        return _mm_packus_epi16(low, high);
+    }
+
+    __attribute__((target("ssse3"))) void pack_ssse3(
+        const colour* colours,
+        const size_t count,
+        const uint8_t brightness,
+        uint8_t* out)
+    {
+        const __m128i swap = _mm_setr_epi8(1, 0, 2, 4, 3, 5, 7, 6, 8, 10, 9, 11, 13, 12, 14, 15);
+        const __m128i factor = _mm_set1_epi16(static_cast<short>(brightness + 1));
+        const auto* in = reinterpret_cast<const uint8_t*>(colours);
+
+        size_t i = 0;
+        // One LED beyond the lane so the 16 byte load and store stay inside both buffers
+        for (; i + LEDS_PER_LANE + 1 <= count; i += LEDS_PER_LANE)
+        {
+            __m128i lane = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 3)), swap);
+            if (brightness != 255)
+            {
+                lane = scale_lane(lane, factor);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 3), lane);
+        }
+        pack_scalar(colours + i, count - i, brightness, out + i * 3);
+    }
+
+    __attribute__((target("avx2"))) void pack_avx2(
+        const colour* colours,
+        const size_t count,
+        const uint8_t brightness,
+        uint8_t* out)
+    {
+        // vpshufb shuffles within each 128 bit half, so each half holds its own group of 5 LEDs
+        const __m256i swap = _mm256_setr_epi8(
+            1, 0, 2, 4, 3, 5, 7, 6, 8, 10, 9, 11, 13, 12, 14, 15,
+            1, 0, 2, 4, 3, 5, 7, 6, 8, 10, 9, 11, 13, 12, 14, 15);
+        const __m256i factor = _mm256_set1_epi16(static_cast<short>(brightness + 1));
+        const __m256i zero = _mm256_setzero_si256();
+        const auto* in = reinterpret_cast<const uint8_t*>(colours);
+
+        size_t i = 0;
+        for (; i + 2 * LEDS_PER_LANE + 1 <= count; i += 2 * LEDS_PER_LANE)
+        {
+            const uint8_t* source = in + i * 3;
+            __m256i lanes = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + LANE_BYTES)),
+                1);
+            lanes = _mm256_shuffle_epi8(lanes, swap);
+            if (brightness != 255)
+            {
+                const __m256i low = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(lanes, zero), factor), 8);
+                const __m256i high = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(lanes, zero), factor), 8);
+                lanes = _mm256_packus_epi16(low, high);
+            }
+            // The second store overwrites the garbage byte of the first
+            uint8_t* target = out + i * 3;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target), _mm256_castsi256_si128(lanes));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target + LANE_BYTES), _mm256_extracti128_si256(lanes, 1));
+        }
+        pack_ssse3(colours + i, count - i, brightness, out + i * 3);
+    }
+#endif
+
+    pack_function function_for(const kernel which)
+    {
+#ifdef BLINKSTICK_X86_KERNELS
+        switch (which)
+        {
+        case kernel::avx2:
+            return pack_avx2;
+        case kernel::ssse3:
+            return pack_ssse3;
+        case kernel::scalar:
+            break;
+        }
+#else
+        static_cast<void>(which);
+#endif
+        return pack_scalar;
+    }
+}
+
+namespace blinkstick::packing
+{
+    bool supported(const kernel which)
+    {
+#ifdef BLINKSTICK_X86_KERNELS
+        // May run before the compiler's own CPU detection during static initialisation
+        __builtin_cpu_init();
+        switch (which)
+        {
+        case kernel::avx2:
+            return __builtin_cpu_supports("avx2");
+        case kernel::ssse3:
+            return __builtin_cpu_supports("ssse3");
+        case kernel::scalar:
+            return true;
+        }
+        return false;
+#else
+        return which == kernel::scalar;
+#endif
+    }
+
+    kernel best_kernel()
+    {
+        static const kernel best = supported(kernel::avx2) ? kernel::avx2
+            : supported(kernel::ssse3)                    ? kernel::ssse3
+                                                          : kernel::scalar;
+        return best;
+    }
+
+    void pack_grb(const colour* colours, const size_t count, const uint8_t brightness, uint8_t* out)
+    {
+        static const pack_function best = function_for(best_kernel());
+        best(colours, count, brightness, out);
+    }
+
+    void pack_grb(const kernel which, const colour* colours, const size_t count, const uint8_t brightness, uint8_t* out)
+    {
+        function_for(which)(colours, count, brightness, out);
+    }
+
+    void pack_grb(const colour* colours, const size_t count, const colour_correction& tables, uint8_t* out)
+    {
+        for (size_t i = 0; i < count; ++i, out += 3)
+        {
+            out[0] = tables.green[colours[i].green];
+            out[1] = tables.red[colours[i].red];
+            out[2] = tables.blue[colours[i].blue];
+        }
+    }
+}
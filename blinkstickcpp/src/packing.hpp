@@ -0,0 +1,56 @@
+#pragma once
+
+#include "blinkstick/correction.hpp"
+#include "blinkstick/device.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// Conversion of colour arrays into the GRB payload of the bulk colour reports
+namespace blinkstick::packing
+{
+    static_assert(sizeof(colour) == 3, "colour arrays are treated as packed RGB triplets");
+
+    enum class kernel
+    {
+        scalar,
+        ssse3,
+        avx2
+    };
+
+    /**
+     * @brief Scales a channel value by a brightness where 255 leaves it unchanged.
+     */
+    constexpr uint8_t scale(const uint8_t value, const uint8_t brightness)
+    {
+        return static_cast<uint8_t>((value * (brightness + 1)) >> 8);
+    }
+
+    /**
+     * @brief The fastest kernel the CPU supports, detected once.
+     */
+    kernel best_kernel();
+
+    /**
+     * @brief Whether the CPU can run a kernel.
+     */
+    bool supported(kernel which);
+
+    /**
+     * @brief Writes count colours to out as GRB triplets, scaled by brightness, using the best kernel.
+     * @param out must have room for count * 3 bytes.
+     */
+    void pack_grb(const colour* colours, size_t count, uint8_t brightness, uint8_t* out);
+
+    /**
+     * @brief Same as pack_grb() with a specific kernel, which must be supported().
+     */
+    void pack_grb(kernel which, const colour* colours, size_t count, uint8_t brightness, uint8_t* out);
+
+    /**
+     * @brief Writes count colours to out as GRB triplets, mapping each channel through a lookup table.
+     * @details Byte lookups do not vectorise, so this always runs the scalar loop, but still
+     * reads and writes every LED once.
+     */
+    void pack_grb(const colour* colours, size_t count, const colour_correction& tables, uint8_t* out);
+}
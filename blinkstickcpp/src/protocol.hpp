@@ -0,0 +1,146 @@
+#pragma once
+
+#include "blinkstick/device.hpp"
+#include "blinkstick/variant.hpp"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Wire format of the BlinkStick feature reports, shared by the device and the simulator
+namespace blinkstick::protocol
+{
+    constexpr int MODE_MSG_SIZE = 2;
+    constexpr int COUNT_MSG_SIZE = 2;
+    constexpr int INDEXED_MSG_SIZE = 6;
+
+    // Every feature report travels as a USB control transfer, which adds an 8 byte setup
+    // packet on top of the report itself
+    constexpr int TRANSFER_OVERHEAD = 8;
+
+    // The largest bulk colour report: report ID, channel and 64 GRB triplets
+    constexpr int MAX_REPORT_SIZE = 64 * 3 + 2;
+
+    /**
+     * @brief A single LED report, which is either 4 (report 1) or 6 (report 5) bytes long.
+     */
+    struct control_message
+    {
+        std::array<uint8_t, INDEXED_MSG_SIZE> bytes;
+        size_t length;
+
+        constexpr const uint8_t* data() const
+        {
+            return bytes.data();
+        }
+
+        constexpr size_t size() const
+        {
+            return length;
+        }
+    };
+
+    constexpr control_message build_control_message(const uint8_t index, const uint8_t channel, uint8_t red, uint8_t green, uint8_t blue)
+    {
+        // Write to the first LED present
+        // this will be the _only_ led for the original blinkstick
+        if (index == 0 && channel == 0)
+        {
+            return
+            {
+                {
+                    0x1,
+                    red,
+                    green,
+                    blue
+                },
+                4
+            };
+        }
+
+        // Writing to the other LEDs requires a different payload
+        // this changes the write mode (first two bytes) and then
+        // assigns the index.
+        return
+        {
+            {
+                0x5,
+                channel,
+                index,
+                red,
+                green,
+                blue
+            },
+            INDEXED_MSG_SIZE
+        };
+    }
+
+    constexpr std::array<uint8_t, MODE_MSG_SIZE> build_mode_message(blinkstick::mode mode)
+    {
+        return
+        {
+            0x0004,
+            static_cast<uint8_t>(mode)
+        };
+    }
+
+    constexpr std::array<uint8_t, COUNT_MSG_SIZE> build_count_message(const uint8_t count)
+    {
+        return
+        {
+            0x81,
+            count
+        };
+    }
+
+    // count is in bytes, three per LED
+    constexpr std::pair<uint8_t, uint8_t> determine_report_id(const int count)
+    {
+        const auto layout = bulk_report_for((count + 2) / 3);
+        return { layout.report_id, static_cast<uint8_t>(layout.max_leds) };
+    }
+
+    /**
+     * @brief Number of LEDs carried by one of the bulk colour reports (6 - 10).
+     * @return the LED count, or 0 if report_id is not a bulk colour report.
+     */
+    constexpr int max_leds_for_report(const uint8_t report_id)
+    {
+        switch (report_id)
+        {
+        case 6:
+            return 8;
+        case 7:
+            return 16;
+        case 8:
+            return 32;
+        case 9:
+        case 10:
+            return 64;
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * @brief Whether updating changes LEDs one by one costs fewer bytes on the bus than one bulk
+     * report carrying max_leds LEDs.
+     */
+    constexpr bool indexed_is_cheaper(const int changes, const int max_leds)
+    {
+        return changes * (INDEXED_MSG_SIZE + TRANSFER_OVERHEAD) < max_leds * 3 + 2 + TRANSFER_OVERHEAD;
+    }
+
+    /**
+     * @brief Decodes the GRB triplets of a bulk colour report payload into colours.
+     * @param payload the report bytes following the report ID and channel.
+     */
+    inline void decode_colours(const uint8_t* payload, const size_t count, blinkstick::colour* colours)
+    {
+        for (size_t i = 0; i < count; ++i, payload += 3)
+        {
+            colours[i] = blinkstick::colour{ payload[1], payload[0], payload[2] };
+        }
+    }
+}
@@ -0,0 +1,149 @@
+#include "blinkstick/registry.hpp"
+#include "blinkstick/blinkstick.hpp"
+
+namespace blinkstick
+{
+    registry::registry(const backend backend) :
+        source(backend)
+    {
+        refresh();
+    }
+
+    void registry::refresh()
+    {
+        auto found = enumerate(source);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<std::string, entry> paths;
+        std::unordered_map<std::string, std::string> serials;
+        paths.reserve(found.size());
+        serials.reserve(found.size());
+
+        for (auto& info : found)
+        {
+            entry item{ std::move(info), std::nullopt };
+            if (const auto existing = by_path.find(item.info.path); existing != by_path.end())
+            {
+                item.handle = std::move(existing->second.handle);
+            }
+            if (!item.info.serial.empty())
+            {
+                serials[item.info.serial] = item.info.path;
+            }
+            auto path = item.info.path;
+            paths.emplace(std::move(path), std::move(item));
+        }
+
+        by_path.swap(paths);
+        serial_to_path.swap(serials);
+    }
+
+    bool registry::add(device_info info)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (by_path.count(info.path) != 0)
+        {
+            return false;
+        }
+        if (!info.serial.empty())
+        {
+            serial_to_path[info.serial] = info.path;
+        }
+        auto path = info.path;
+        by_path.emplace(std::move(path), entry{ std::move(info), std::nullopt });
+        return true;
+    }
+
+    std::optional<device_info> registry::remove(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto found = by_path.find(path);
+        if (found == by_path.end())
+        {
+            return std::nullopt;
+        }
+        auto info = std::move(found->second.info);
+        by_path.erase(found);
+        if (const auto serial = serial_to_path.find(info.serial);
+            serial != serial_to_path.end() && serial->second == path)
+        {
+            serial_to_path.erase(serial);
+        }
+        return info;
+    }
+
+    std::vector<device_info> registry::entries() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<device_info> infos;
+        infos.reserve(by_path.size());
+        for (const auto& [path, item] : by_path)
+        {
+            infos.push_back(item.info);
+        }
+        return infos;
+    }
+
+    size_t registry::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return by_path.size();
+    }
+
+    device registry::get_by_path(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto found = by_path.find(path);
+        if (found == by_path.end())
+        {
+            return device{ std::shared_ptr<transport>(), device_type::unknown };
+        }
+        return open(found->second);
+    }
+
+    device registry::get_by_serial(const std::string& serial)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto path = serial_to_path.find(serial);
+        if (path == serial_to_path.end())
+        {
+            return device{ std::shared_ptr<transport>(), device_type::unknown };
+        }
+        return open(by_path.at(path->second));
+    }
+
+    std::vector<device> registry::open_all()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<device> devices;
+        devices.reserve(by_path.size());
+        for (auto& [path, item] : by_path)
+        {
+            if (auto device = open(item); device.is_valid())
+            {
+                devices.emplace_back(std::move(device));
+            }
+        }
+        return devices;
+    }
+
+    backend registry::get_backend() const
+    {
+        return source;
+    }
+
+    device registry::open(entry& entry)
+    {
+        if (!entry.handle)
+        {
+            // Failed opens are not cached so a later lookup can try again
+            auto device = open_device(entry.info, source);
+            if (!device.is_valid())
+            {
+                return device;
+            }
+            entry.handle = std::move(device);
+        }
+        return *entry.handle;
+    }
+}
@@ -0,0 +1,326 @@
+#include "blinkstick/simulator.hpp"
+#include "protocol.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    constexpr const char* PATH_PREFIX = "simulator:";
+
+    std::mutex plugged_mutex;
+    std::vector<std::shared_ptr<blinkstick::simulator>> plugged;
+
+    // sleep_for overshoots by tens of microseconds, which would swamp short injected latencies,
+    // so the last stretch is spun out instead
+    void wait_for(const std::chrono::nanoseconds delay)
+    {
+        if (delay <= std::chrono::nanoseconds::zero())
+        {
+            return;
+        }
+        const auto deadline = std::chrono::steady_clock::now() + delay;
+        const auto spin = std::chrono::microseconds(200);
+        if (delay > spin)
+        {
+            std::this_thread::sleep_for(delay - spin);
+        }
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+namespace blinkstick
+{
+    simulator::simulator(const device_type type, const uint8_t led_count, const uint32_t seed) :
+        type(type),
+        random(seed),
+        leds(),
+        led_count(led_count)
+    {
+    }
+
+    void simulator::plug(std::shared_ptr<simulator> sim)
+    {
+        std::lock_guard<std::mutex> lock(plugged_mutex);
+        plugged.emplace_back(std::move(sim));
+    }
+
+    void simulator::unplug_all()
+    {
+        std::lock_guard<std::mutex> lock(plugged_mutex);
+        plugged.clear();
+    }
+
+    std::vector<device> simulator::find_all()
+    {
+        std::lock_guard<std::mutex> lock(plugged_mutex);
+        std::vector<device> devices;
+        devices.reserve(plugged.size());
+        for (const auto& sim : plugged)
+        {
+            devices.emplace_back(sim, sim->get_type());
+        }
+        return devices;
+    }
+
+    std::vector<device_info> simulator::enumerate()
+    {
+        std::lock_guard<std::mutex> lock(plugged_mutex);
+        std::vector<device_info> devices;
+        devices.reserve(plugged.size());
+        for (size_t i = 0; i < plugged.size(); ++i)
+        {
+            devices.push_back(
+                device_info{ PATH_PREFIX + std::to_string(i), "SIM" + std::to_string(i), plugged[i]->get_type() });
+        }
+        return devices;
+    }
+
+    std::shared_ptr<simulator> simulator::open(const std::string& path)
+    {
+        if (path.rfind(PATH_PREFIX, 0) != 0)
+        {
+            return nullptr;
+        }
+        const auto index = std::strtoul(path.c_str() + std::strlen(PATH_PREFIX), nullptr, 10);
+
+        std::lock_guard<std::mutex> lock(plugged_mutex);
+        if (index >= plugged.size())
+        {
+            return nullptr;
+        }
+        return plugged[index];
+    }
+
+    bool simulator::send_feature_report(const uint8_t* data, const size_t size)
+    {
+        if (size == 0)
+        {
+            return false;
+        }
+        const auto [delay, fail] = draw(data[0]);
+        wait_for(delay);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fail || !apply(data, size))
+        {
+            ++failures[data[0]];
+            return false;
+        }
+        ++reports[data[0]];
+        return true;
+    }
+
+    bool simulator::get_feature_report(uint8_t* data, const size_t size)
+    {
+        if (size == 0)
+        {
+            return false;
+        }
+        const auto [delay, fail] = draw(data[0]);
+        wait_for(delay);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fail || !fill(data, size))
+        {
+            ++failures[data[0]];
+            return false;
+        }
+        ++reports[data[0]];
+        return true;
+    }
+
+    void simulator::set_profile(const report_profile& profile)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        default_profile = profile;
+    }
+
+    void simulator::set_profile(const uint8_t report_id, const report_profile& profile)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        profiles[report_id] = profile;
+    }
+
+    device_type simulator::get_type() const
+    {
+        return type;
+    }
+
+    colour simulator::get_colour(const int channel, const int index) const
+    {
+        if (channel < 0 || channel >= channel_count || index < 0 || index >= max_leds)
+        {
+            return {};
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        return leds[channel][index];
+    }
+
+    std::vector<colour> simulator::get_colours(const int channel) const
+    {
+        if (channel < 0 || channel >= channel_count)
+        {
+            return {};
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        return { leds[channel].begin(), leds[channel].end() };
+    }
+
+    mode simulator::get_mode() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return current_mode;
+    }
+
+    uint8_t simulator::get_led_count() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return led_count;
+    }
+
+    uint64_t simulator::report_count(const uint8_t report_id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return reports[report_id];
+    }
+
+    uint64_t simulator::failure_count(const uint8_t report_id) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failures[report_id];
+    }
+
+    std::pair<std::chrono::nanoseconds, bool> simulator::draw(const uint8_t report_id)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto found = profiles.find(report_id);
+        const auto& profile = found != profiles.end() ? found->second : default_profile;
+
+        auto delay = profile.latency;
+        if (profile.jitter.count() > 0)
+        {
+            std::uniform_int_distribution<std::chrono::nanoseconds::rep> jitter(0, profile.jitter.count());
+            delay += std::chrono::nanoseconds(jitter(random));
+        }
+
+        bool fail = false;
+        if (profile.failure_rate > 0.0)
+        {
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            fail = chance(random) < profile.failure_rate;
+        }
+        return { delay, fail };
+    }
+
+    bool simulator::apply(const uint8_t* data, const size_t size)
+    {
+        const uint8_t report_id = data[0];
+        switch (report_id)
+        {
+        case 0x1:
+            // [1, red, green, blue] always addresses the first LED of channel 0
+            if (size < 4)
+            {
+                return false;
+            }
+            leds[0][0] = colour{ data[1], data[2], data[3] };
+            return true;
+        case 0x4:
+            if (size < 2)
+            {
+                return false;
+            }
+            current_mode = static_cast<mode>(data[1]);
+            return true;
+        case 0x5:
+            // [5, channel, index, red, green, blue]
+            if (size < 6 || data[1] >= channel_count || data[2] >= max_leds)
+            {
+                return false;
+            }
+            leds[data[1]][data[2]] = colour{ data[3], data[4], data[5] };
+            return true;
+        case 0x81:
+            if (size < 2)
+            {
+                return false;
+            }
+            led_count = data[1];
+            return true;
+        default:
+            break;
+        }
+
+        // [report_id, channel, green, red, blue, ...]
+        const int report_leds = protocol::max_leds_for_report(report_id);
+        if (report_leds == 0 || size < 2 || data[1] >= channel_count)
+        {
+            return false;
+        }
+        auto& channel = leds[data[1]];
+        const int count = std::min(report_leds, static_cast<int>((size - 2) / 3));
+        for (int i = 0; i < count; ++i)
+        {
+            const uint8_t* grb = data + 2 + static_cast<size_t>(i) * 3;
+            channel[i] = colour{ grb[1], grb[0], grb[2] };
+        }
+        return true;
+    }
+
+    bool simulator::fill(uint8_t* data, const size_t size)
+    {
+        const uint8_t report_id = data[0];
+        switch (report_id)
+        {
+        case 0x1:
+            if (size < 4)
+            {
+                return false;
+            }
+            data[1] = leds[0][0].red;
+            data[2] = leds[0][0].green;
+            data[3] = leds[0][0].blue;
+            return true;
+        case 0x4:
+            if (size < 2)
+            {
+                return false;
+            }
+            data[1] = static_cast<uint8_t>(current_mode);
+            return true;
+        case 0x81:
+            if (size < 2)
+            {
+                return false;
+            }
+            data[1] = led_count;
+            return true;
+        default:
+            break;
+        }
+
+        // Reading a bulk report returns the LEDs of channel 0
+        const int report_leds = protocol::max_leds_for_report(report_id);
+        if (report_leds == 0 || size < 2)
+        {
+            return false;
+        }
+        data[1] = 0;
+        const auto& channel = leds[0];
+        const int count = std::min(report_leds, static_cast<int>((size - 2) / 3));
+        for (int i = 0; i < count; ++i)
+        {
+            uint8_t* grb = data + 2 + static_cast<size_t>(i) * 3;
+            grb[0] = channel[i].green;
+            grb[1] = channel[i].red;
+            grb[2] = channel[i].blue;
+        }
+        return true;
+    }
+}
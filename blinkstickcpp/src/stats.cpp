@@ -0,0 +1,158 @@
+#include "blinkstick/stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    int most_significant_bit(uint64_t value)
+    {
+        int bit = 0;
+        while (value >>= 1)
+        {
+            ++bit;
+        }
+        return bit;
+    }
+}
+
+namespace blinkstick
+{
+    std::chrono::nanoseconds histogram_snapshot::percentile(const double fraction) const
+    {
+        if (count == 0)
+        {
+            return std::chrono::nanoseconds::zero();
+        }
+        const auto wanted = std::max<uint64_t>(
+            1, static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count))));
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i)
+        {
+            seen += buckets[i];
+            // Values past max_exponent are clamped into the last bucket, so only the maximum bounds it
+            if (seen >= wanted && i + 1 < buckets.size())
+            {
+                const auto bound = latency_histogram::bucket_upper_bound(i) - 1;
+                return std::chrono::nanoseconds(std::min(bound, max_ns));
+            }
+        }
+        return std::chrono::nanoseconds(max_ns);
+    }
+
+    std::chrono::nanoseconds histogram_snapshot::mean() const
+    {
+        return std::chrono::nanoseconds(count == 0 ? 0 : total_ns / count);
+    }
+
+    size_t latency_histogram::bucket_index(const uint64_t ns)
+    {
+        if (ns < sub_bucket_count)
+        {
+            return static_cast<size_t>(ns);
+        }
+        const int exponent = std::min(most_significant_bit(ns), max_exponent);
+        const int shift = exponent - sub_bucket_bits;
+        const auto sub_bucket = std::min<uint64_t>((ns >> shift) - sub_bucket_count, sub_bucket_count - 1);
+        return static_cast<size_t>(sub_bucket_count * (shift + 1) + sub_bucket);
+    }
+
+    uint64_t latency_histogram::bucket_upper_bound(const size_t index)
+    {
+        if (index < sub_bucket_count)
+        {
+            return index + 1;
+        }
+        const int shift = static_cast<int>(index / sub_bucket_count) - 1;
+        const uint64_t sub_bucket = index % sub_bucket_count;
+        return (sub_bucket_count + sub_bucket + 1) << shift;
+    }
+
+    void latency_histogram::record(const std::chrono::nanoseconds latency)
+    {
+        const auto ns = static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>(latency.count(), 0));
+        buckets[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+        auto current = max_ns.load(std::memory_order_relaxed);
+        while (ns > current && !max_ns.compare_exchange_weak(current, ns, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    histogram_snapshot latency_histogram::snapshot() const
+    {
+        histogram_snapshot copy;
+        copy.buckets.reserve(buckets.size());
+        for (const auto& bucket : buckets)
+        {
+            copy.buckets.push_back(bucket.load(std::memory_order_relaxed));
+        }
+        copy.count = count.load(std::memory_order_relaxed);
+        copy.total_ns = total_ns.load(std::memory_order_relaxed);
+        copy.max_ns = max_ns.load(std::memory_order_relaxed);
+        return copy;
+    }
+
+    void device_stats::record_send(
+        const uint8_t report_id,
+        const size_t size,
+        const std::chrono::nanoseconds latency,
+        const bool ok)
+    {
+        send_latency.record(latency);
+        if (!ok)
+        {
+            errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        reports_sent[report_id].fetch_add(1, std::memory_order_relaxed);
+        bytes_sent.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void device_stats::record_get(
+        const uint8_t report_id,
+        const size_t size,
+        const std::chrono::nanoseconds latency,
+        const bool ok)
+    {
+        get_latency.record(latency);
+        if (!ok)
+        {
+            errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        reports_read[report_id].fetch_add(1, std::memory_order_relaxed);
+        bytes_read.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void device_stats::record_retry()
+    {
+        retries.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void device_stats::record_frame()
+    {
+        frames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    stats_snapshot device_stats::snapshot() const
+    {
+        stats_snapshot copy;
+        for (size_t i = 0; i < reports_sent.size(); ++i)
+        {
+            copy.reports_sent[i] = reports_sent[i].load(std::memory_order_relaxed);
+            copy.reports_read[i] = reports_read[i].load(std::memory_order_relaxed);
+        }
+        copy.frames = frames.load(std::memory_order_relaxed);
+        copy.bytes_sent = bytes_sent.load(std::memory_order_relaxed);
+        copy.bytes_read = bytes_read.load(std::memory_order_relaxed);
+        copy.errors = errors.load(std::memory_order_relaxed);
+        copy.retries = retries.load(std::memory_order_relaxed);
+        copy.send_latency = send_latency.snapshot();
+        copy.get_latency = get_latency.snapshot();
+        return copy;
+    }
+}
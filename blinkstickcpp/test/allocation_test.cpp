@@ -0,0 +1,158 @@
+#include "check.hpp"
+
+#include <blinkstick/async_writer.hpp>
+#include <blinkstick/concurrent_device.hpp>
+#include <blinkstick/device.hpp>
+#include <blinkstick/transport.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace
+{
+    std::atomic<size_t> allocations{ 0 };
+}
+
+void* operator new(const std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    constexpr int WARM_FRAMES = 4;
+    constexpr int MEASURED_FRAMES = 100;
+
+    // Accepts every report and answers the LED count query
+    class sink_transport : public blinkstick::transport
+    {
+    public:
+        explicit sink_transport(const uint8_t led_count) :
+            led_count(led_count)
+        {
+        }
+
+        bool send_feature_report(const uint8_t*, size_t) override
+        {
+            return true;
+        }
+
+        bool get_feature_report(uint8_t* data, const size_t size) override
+        {
+            if (size > 1)
+            {
+                data[1] = led_count;
+            }
+            return true;
+        }
+
+    private:
+        uint8_t led_count;
+    };
+
+    // Runs frame for a few warm-up frames, then counts the allocations of the measured ones
+    template<typename Frame>
+    size_t allocations_per_run(Frame frame)
+    {
+        for (int i = 0; i < WARM_FRAMES; ++i)
+        {
+            frame(i);
+        }
+        const size_t before = allocations.load();
+        for (int i = WARM_FRAMES; i < WARM_FRAMES + MEASURED_FRAMES; ++i)
+        {
+            frame(i);
+        }
+        return allocations.load() - before;
+    }
+
+    void test_device(const blinkstick::device_type type, const uint8_t led_count, const char* name)
+    {
+        const blinkstick::device target(std::make_shared<sink_transport>(led_count), type);
+        const auto leds = static_cast<size_t>(target.get_led_count());
+        std::vector<blinkstick::colour> frame(leds);
+
+        // Every frame differs from the last so delta encoding never skips the send
+        const auto shade = [](const int i) { return static_cast<uint8_t>(i); };
+
+        const auto single = allocations_per_run([&](const int i) { target.set_colour(0, i % static_cast<int>(leds), shade(i), 0, 0); });
+        const auto solid = allocations_per_run([&](const int i) { target.set_colours(0, shade(i), 1, 2); });
+        const auto vector = allocations_per_run([&](const int i) {
+            frame.assign(leds, blinkstick::colour{ shade(i), 3, 4 });
+            target.set_colours(0, frame);
+        });
+        const auto pointer = allocations_per_run([&](const int i) {
+            frame.assign(leds, blinkstick::colour{ 5, shade(i), 6 });
+            target.set_colours(0, frame.data(), frame.size());
+        });
+
+        std::printf("%s (%zu leds): set_colour %zu, solid %zu, vector %zu, pointer %zu\n", name, leds, single, solid, vector, pointer);
+        CHECK(single == 0);
+        CHECK(solid == 0);
+        CHECK(vector == 0);
+        CHECK(pointer == 0);
+    }
+
+    void test_async_writer()
+    {
+        blinkstick::async_writer writer(
+            blinkstick::device(std::make_shared<sink_transport>(0), blinkstick::device_type::strip));
+        std::vector<blinkstick::colour> frame(8);
+
+        const auto submits = allocations_per_run([&](const int i) {
+            frame.assign(frame.size(), blinkstick::colour{ static_cast<uint8_t>(i), 1, 2 });
+            writer.submit(0, frame.data(), frame.size());
+            writer.flush();
+        });
+
+        std::printf("async_writer: submit %zu\n", submits);
+        CHECK(submits == 0);
+    }
+
+    void test_concurrent_device()
+    {
+        blinkstick::concurrent_device queue(
+            blinkstick::device(std::make_shared<sink_transport>(0), blinkstick::device_type::strip));
+
+        const auto commands = allocations_per_run([&](const int i) {
+            queue.set_colour(0, i % 8, static_cast<uint8_t>(i), 1, 2);
+            queue.set_mode(blinkstick::mode::normal);
+            queue.flush();
+        });
+
+        std::printf("concurrent_device: set_colour %zu\n", commands);
+        CHECK(commands == 0);
+    }
+}
+
+int main()
+{
+    test_device(blinkstick::device_type::strip, 0, "strip");
+    test_device(blinkstick::device_type::flex, 32, "flex");
+    test_device(blinkstick::device_type::pro, 192, "pro");
+    test_async_writer();
+    test_concurrent_device();
+
+    // Creating the devices allocates, so a zero here would mean the counter is not hooked up
+    CHECK(allocations.load() > 0);
+    return check::result();
+}
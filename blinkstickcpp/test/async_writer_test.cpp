@@ -0,0 +1,114 @@
+#include "check.hpp"
+
+#include <blinkstick/async_writer.hpp>
+#include <blinkstick/transport.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    // Holds every report until released and remembers the last colour report it was given
+    class gated_transport : public blinkstick::transport
+    {
+    public:
+        bool send_feature_report(const uint8_t* data, const size_t size) override
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ++entered;
+            changed.notify_all();
+            changed.wait(lock, [this] { return open; });
+            last.assign(data, data + size);
+            return !failing;
+        }
+
+        bool get_feature_report(uint8_t*, size_t) override
+        {
+            return true;
+        }
+
+        void wait_for_entered(const int count)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return entered >= count; });
+        }
+
+        void release()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                open = true;
+            }
+            changed.notify_all();
+        }
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        int entered = 0;
+        bool open = false;
+        bool failing = false;
+        std::vector<uint8_t> last;
+    };
+
+    std::vector<blinkstick::colour> solid(const uint8_t red)
+    {
+        return std::vector<blinkstick::colour>(8, blinkstick::colour{ red, 0, 0 });
+    }
+
+    void test_latest_frame_wins()
+    {
+        auto io = std::make_shared<gated_transport>();
+        blinkstick::async_writer writer(blinkstick::device(io, blinkstick::device_type::strip));
+
+        // The first frame is taken by the I/O thread and held in the transport
+        CHECK(writer.submit(0, solid(1)));
+        io->wait_for_entered(1);
+
+        // Each of these replaces the one before, only the last is sent
+        CHECK(writer.submit(0, solid(2)));
+        CHECK(writer.submit(0, solid(3)));
+        CHECK(writer.submit(0, solid(4)));
+
+        io->release();
+        writer.flush();
+
+        const auto stats = writer.get_stats();
+        CHECK(stats.submitted == 4);
+        CHECK(stats.sent == 2);
+        CHECK(stats.dropped == 2);
+        CHECK(stats.failed == 0);
+
+        // [report ID, channel, green, red, blue, ...]
+        std::lock_guard<std::mutex> lock(io->mutex);
+        CHECK(io->entered == 2);
+        CHECK(io->last.size() > 3 && io->last[3] == 4);
+    }
+
+    void test_failed_and_rejected_frames()
+    {
+        auto io = std::make_shared<gated_transport>();
+        io->failing = true;
+        io->release();
+        blinkstick::async_writer writer(blinkstick::device(io, blinkstick::device_type::strip));
+
+        // A strip has a single channel
+        CHECK(!writer.submit(1, solid(1)));
+        CHECK(!writer.submit(-1, solid(1)));
+
+        CHECK(writer.submit(0, solid(1)));
+        writer.flush();
+        const auto stats = writer.get_stats();
+        CHECK(stats.submitted == 1);
+        CHECK(stats.failed == 1);
+        CHECK(stats.sent == 0);
+    }
+}
+
+int main()
+{
+    test_latest_frame_wins();
+    test_failed_and_rejected_frames();
+    return check::result();
+}
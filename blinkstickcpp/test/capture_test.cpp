@@ -0,0 +1,198 @@
+#include "check.hpp"
+
+#include <blinkstick/capture.hpp>
+#include <blinkstick/device.hpp>
+#include <blinkstick/simulator.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const std::string PATH = "capture_test.cap";
+
+    struct expected_record
+    {
+        blinkstick::capture_direction direction;
+        bool ok;
+        uint8_t report_id;
+        size_t size;
+    };
+
+    // What the session in record_session() sends and reads, in order
+    const std::vector<expected_record> EXPECTED = {
+        { blinkstick::capture_direction::send, true, 4, 2 },
+        { blinkstick::capture_direction::send, true, 5, 6 },
+        { blinkstick::capture_direction::get, true, 0x81, 2 },
+        { blinkstick::capture_direction::send, true, 6, 2 + 8 * 3 },
+        { blinkstick::capture_direction::send, false, 5, 6 },
+    };
+
+    std::vector<uint8_t> read_file(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    uint64_t get_le(const uint8_t* in, const size_t bytes)
+    {
+        uint64_t value = 0;
+        for (size_t i = bytes; i > 0; --i)
+        {
+            value = (value << 8) | in[i - 1];
+        }
+        return value;
+    }
+
+    void record_session(const std::shared_ptr<blinkstick::simulator>& sim)
+    {
+        auto recorder = blinkstick::recording_transport::open(PATH, sim);
+        CHECK(recorder != nullptr);
+        const blinkstick::device target(recorder, blinkstick::device_type::flex);
+
+        CHECK(target.set_mode(blinkstick::mode::normal));
+        CHECK(target.set_colour(0, 2, 10, 20, 30));
+        CHECK(target.set_colours(0, std::vector<blinkstick::colour>(8, blinkstick::colour{ 1, 2, 3 })));
+
+        // Failed sends are recorded too
+        sim->set_profile(5, blinkstick::report_profile{ {}, {}, 1.0 });
+        CHECK(!target.set_colour(0, 3, 4, 5, 6));
+        sim->set_profile(5, blinkstick::report_profile{});
+        CHECK(recorder->flush());
+    }
+
+    void test_file_layout()
+    {
+        const auto bytes = read_file(PATH);
+        CHECK(bytes.size() >= 16);
+        if (bytes.size() < 16)
+        {
+            return;
+        }
+
+        // 16 byte header: the magic, a NUL, the version and a reserved word
+        CHECK(std::string(bytes.begin(), bytes.begin() + 8) == std::string("BSTKCAP", 8));
+        CHECK(get_le(bytes.data() + 8, 4) == 1);
+        CHECK(get_le(bytes.data() + 12, 4) == 0);
+
+        // 12 byte records: time, size, direction and success flag, then the report
+        size_t position = 16;
+        uint64_t last_time = 0;
+        for (const auto& expected : EXPECTED)
+        {
+            CHECK(bytes.size() - position >= 12 + expected.size);
+            if (bytes.size() - position < 12 + expected.size)
+            {
+                return;
+            }
+            const uint8_t* header = bytes.data() + position;
+            const uint64_t time = get_le(header, 8);
+            CHECK(time >= last_time);
+            CHECK(get_le(header + 8, 2) == expected.size);
+            CHECK(header[10] == static_cast<uint8_t>(expected.direction));
+            CHECK(header[11] == (expected.ok ? 1 : 0));
+            CHECK(header[12] == expected.report_id);
+            last_time = time;
+            position += 12 + expected.size;
+        }
+        CHECK(position == bytes.size());
+    }
+
+    void test_reader()
+    {
+        const auto bytes = read_file(PATH);
+        blinkstick::capture_reader reader(PATH);
+        CHECK(reader.is_open());
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            blinkstick::capture_record record;
+            size_t position = 16;
+            for (const auto& expected : EXPECTED)
+            {
+                CHECK(reader.next(record));
+                CHECK(record.direction == expected.direction);
+                CHECK(record.ok == expected.ok);
+                CHECK(record.size == expected.size);
+                CHECK(record.time.count() == static_cast<int64_t>(get_le(bytes.data() + position, 8)));
+                CHECK(std::vector<uint8_t>(record.data, record.data + record.size)
+                    == std::vector<uint8_t>(bytes.begin() + position + 12, bytes.begin() + position + 12 + record.size));
+                position += 12 + record.size;
+            }
+            CHECK(!reader.next(record));
+            reader.rewind();
+        }
+    }
+
+    void test_truncated_and_invalid()
+    {
+        const auto bytes = read_file(PATH);
+        const std::string truncated = "capture_test_truncated.cap";
+        {
+            // Cut the last record short, as a crash while recording would
+            std::ofstream file(truncated, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size() - 1));
+        }
+        blinkstick::capture_reader reader(truncated);
+        CHECK(reader.is_open());
+        blinkstick::capture_record record;
+        size_t records = 0;
+        while (reader.next(record))
+        {
+            ++records;
+        }
+        CHECK(records == EXPECTED.size() - 1);
+        std::remove(truncated.c_str());
+
+        const std::string invalid = "capture_test_invalid.cap";
+        {
+            std::ofstream file(invalid, std::ios::binary);
+            file << "not a capture file at all";
+        }
+        CHECK(!blinkstick::capture_reader(invalid).is_open());
+        std::remove(invalid.c_str());
+        CHECK(!blinkstick::capture_reader("capture_test_missing.cap").is_open());
+    }
+
+    void test_replay(const blinkstick::simulator& recorded)
+    {
+        blinkstick::capture_reader reader(PATH);
+        blinkstick::simulator target(blinkstick::device_type::flex, 8);
+        const auto result = blinkstick::replay(reader, target, 0);
+
+        // Every send is replayed, including the one that failed while recording, and reads are skipped
+        CHECK(result.sent == 4);
+        CHECK(result.failed == 0);
+        CHECK(result.skipped == 1);
+        for (const uint8_t id : { 4, 5, 6 })
+        {
+            CHECK(target.report_count(id) == recorded.report_count(id) + recorded.failure_count(id));
+        }
+        CHECK(target.report_count(0x81) == 0);
+
+        // The failed send reaches the replay target, so only that LED differs
+        auto expected = recorded.get_colours(0);
+        expected[3] = blinkstick::colour{ 4, 5, 6 };
+        CHECK(target.get_colours(0) == expected);
+        CHECK(target.get_mode() == recorded.get_mode());
+    }
+}
+
+int main()
+{
+    auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 8);
+    record_session(sim);
+
+    test_file_layout();
+    test_reader();
+    test_truncated_and_invalid();
+    test_replay(*sim);
+
+    std::remove(PATH.c_str());
+    return check::result();
+}
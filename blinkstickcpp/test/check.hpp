@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the unit tests, which are plain executables run by ctest
+namespace check
+{
+    inline int failures = 0;
+
+    /**
+     * @brief The exit code of a test executable.
+     */
+    inline int result()
+    {
+        if (failures != 0)
+        {
+            std::fprintf(stderr, "%d check(s) failed\n", failures);
+        }
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+#define CHECK(condition)                                                                                      \
+    do                                                                                                        \
+    {                                                                                                         \
+        if (!(condition))                                                                                     \
+        {                                                                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);                \
+            ++check::failures;                                                                                \
+        }                                                                                                     \
+    } while (false)
@@ -0,0 +1,112 @@
+#include "check.hpp"
+
+#include <blinkstick/colour_space.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using blinkstick::colour;
+    using blinkstick::hsl;
+    using blinkstick::hsv;
+
+    const colour GUARD{ 0xA5, 0x5A, 0xA5 };
+
+    // The array functions use SSSE3 where available, the single colour ones are always scalar
+    void test_every_input()
+    {
+        std::vector<hsv> hsv_in(65536);
+        std::vector<hsl> hsl_in(65536);
+        std::vector<colour> out(65536);
+        size_t mismatches = 0;
+
+        for (int hue = 0; hue < 256; ++hue)
+        {
+            for (int i = 0; i < 65536; ++i)
+            {
+                hsv_in[i] = hsv{ static_cast<uint8_t>(hue), static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i) };
+                hsl_in[i] = hsl{ static_cast<uint8_t>(hue), static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i) };
+            }
+
+            blinkstick::hsv_to_rgb(hsv_in.data(), hsv_in.size(), out.data());
+            for (int i = 0; i < 65536; ++i)
+            {
+                mismatches += out[i] == blinkstick::hsv_to_rgb(hsv_in[i]) ? 0 : 1;
+            }
+
+            blinkstick::hsl_to_rgb(hsl_in.data(), hsl_in.size(), out.data());
+            for (int i = 0; i < 65536; ++i)
+            {
+                mismatches += out[i] == blinkstick::hsl_to_rgb(hsl_in[i]) ? 0 : 1;
+            }
+        }
+        if (mismatches > 0)
+        {
+            std::printf("%zu conversions differ from scalar\n", mismatches);
+        }
+        CHECK(mismatches == 0);
+    }
+
+    void test_tails()
+    {
+        // Every length around the 16 colour blocks, at every alignment within a block
+        std::mt19937 random(22);
+        for (size_t count = 0; count <= 70; ++count)
+        {
+            for (size_t start = 0; start < 16; ++start)
+            {
+                std::vector<hsv> hsv_in(start + count);
+                std::vector<hsl> hsl_in(start + count);
+                for (size_t i = 0; i < hsv_in.size(); ++i)
+                {
+                    const auto bits = random();
+                    hsv_in[i] = hsv{ static_cast<uint8_t>(bits), static_cast<uint8_t>(bits >> 8), static_cast<uint8_t>(bits >> 16) };
+                    hsl_in[i] = hsl{ static_cast<uint8_t>(bits >> 4), static_cast<uint8_t>(bits >> 12), static_cast<uint8_t>(bits >> 20) };
+                }
+
+                std::vector<colour> out(count + 8, GUARD);
+                blinkstick::hsv_to_rgb(hsv_in.data() + start, count, out.data());
+                for (size_t i = 0; i < count; ++i)
+                {
+                    CHECK(out[i] == blinkstick::hsv_to_rgb(hsv_in[start + i]));
+                }
+                for (size_t i = count; i < out.size(); ++i)
+                {
+                    CHECK(out[i] == GUARD);
+                }
+
+                out.assign(count + 8, GUARD);
+                blinkstick::hsl_to_rgb(hsl_in.data() + start, count, out.data());
+                for (size_t i = 0; i < count; ++i)
+                {
+                    CHECK(out[i] == blinkstick::hsl_to_rgb(hsl_in[start + i]));
+                }
+                for (size_t i = count; i < out.size(); ++i)
+                {
+                    CHECK(out[i] == GUARD);
+                }
+            }
+        }
+    }
+
+    void test_known_colours()
+    {
+        CHECK(blinkstick::hsv_to_rgb(hsv{ 0, 255, 255 }) == (colour{ 255, 0, 0 }));
+        CHECK(blinkstick::hsv_to_rgb(hsv{ 0, 0, 255 }) == (colour{ 255, 255, 255 }));
+        CHECK(blinkstick::hsv_to_rgb(hsv{ 200, 255, 0 }) == (colour{ 0, 0, 0 }));
+        CHECK(blinkstick::hsl_to_rgb(hsl{ 0, 255, 255 }) == (colour{ 255, 255, 255 }));
+        CHECK(blinkstick::hsl_to_rgb(hsl{ 0, 0, 0 }) == (colour{ 0, 0, 0 }));
+        CHECK(blinkstick::hsl_to_rgb(hsl{ 0, 0, 128 }) == (colour{ 128, 128, 128 }));
+    }
+}
+
+int main()
+{
+    test_known_colours();
+    test_every_input();
+    test_tails();
+    return check::result();
+}
@@ -0,0 +1,105 @@
+#include "check.hpp"
+
+#include <blinkstick/concurrent_device.hpp>
+#include <blinkstick/simulator.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void test_flush_under_sustained_producers()
+    {
+        // Slow enough that the producers below keep the queue from running dry
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 8);
+        sim->set_profile(blinkstick::report_profile{ std::chrono::microseconds(200) });
+        blinkstick::concurrent_device queue(blinkstick::device(sim, blinkstick::device_type::flex));
+
+        // Keep a bounded backlog queued at all times, so the queue never empties but each flush()
+        // only has a few commands to wait for
+        const auto sent = [&] { return sim->report_count(1) + sim->report_count(5); };
+        std::atomic<uint64_t> queued{ 0 };
+        std::atomic<bool> producing{ true };
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 2; ++p)
+        {
+            producers.emplace_back([&, p] {
+                for (int i = 0; producing; ++i)
+                {
+                    if (queued - sent() > 32)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    ++queued;
+                    queue.set_colour(0, i % 8, static_cast<uint8_t>(i), static_cast<uint8_t>(p), 0);
+                }
+            });
+        }
+
+        auto flushed = std::async(std::launch::async, [&] {
+            for (int i = 0; i < 5; ++i)
+            {
+                queue.flush();
+            }
+        });
+        const bool finished = flushed.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+        CHECK(finished);
+
+        producing = false;
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        if (!finished)
+        {
+            // flush() is stuck for good, and so would be every destructor from here on
+            std::_Exit(check::result());
+        }
+    }
+
+    void test_destructor_runs_accepted_commands()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 8);
+        sim->set_profile(blinkstick::report_profile{ std::chrono::microseconds(50) });
+
+        // More commands than the ring holds, so some producers also have to wait for free cells
+        std::atomic<uint64_t> accepted{ 0 };
+        {
+            blinkstick::concurrent_device queue(blinkstick::device(sim, blinkstick::device_type::flex));
+            std::vector<std::thread> producers;
+            for (int p = 0; p < 4; ++p)
+            {
+                producers.emplace_back([&, p] {
+                    for (int i = 0; i < 200; ++i)
+                    {
+                        if (queue.set_colour(0, i % 8, static_cast<uint8_t>(i), static_cast<uint8_t>(p), 0))
+                        {
+                            ++accepted;
+                        }
+                    }
+                });
+            }
+            for (auto& producer : producers)
+            {
+                producer.join();
+            }
+            CHECK(queue.failed_commands() == 0);
+        }
+
+        CHECK(accepted == 800);
+        CHECK(sim->report_count(1) + sim->report_count(5) == accepted);
+    }
+}
+
+int main()
+{
+    test_flush_under_sustained_producers();
+    test_destructor_runs_accepted_commands();
+    return check::result();
+}
@@ -0,0 +1,69 @@
+#include "check.hpp"
+
+#include <blinkstick/correction.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    // The tables are usable in constant expressions
+    static_assert(blinkstick::gamma_2_2[0] == 0, "black stays black");
+    static_assert(blinkstick::gamma_2_2[255] == 255, "full stays full");
+    static_assert(blinkstick::make_identity_table()[77] == 77, "identity");
+    static_assert(blinkstick::make_correction(blinkstick::make_identity_table(), { 127, 255, 0 }).red[255] == 127,
+        "white balance scales the top of the table");
+
+    void test_gamma_matches_pow()
+    {
+        for (const double gamma : { 0.45, 1.0, 1.8, 2.2, 2.5, 2.8 })
+        {
+            const auto table = blinkstick::make_gamma_table(gamma);
+            CHECK(table[0] == 0);
+            for (int i = 1; i < 256; ++i)
+            {
+                const long expected = std::lround(255.0 * std::pow(i / 255.0, gamma));
+                if (std::labs(table[i] - expected) > 1)
+                {
+                    std::printf("gamma %.2f: table[%d] = %d, pow gives %ld\n", gamma, i, table[i], expected);
+                }
+                CHECK(std::labs(table[i] - expected) <= 1);
+            }
+        }
+
+        // The shared table is the one make_gamma_table() builds
+        CHECK(blinkstick::gamma_2_2 == blinkstick::make_gamma_table(2.2));
+    }
+
+    void test_log_and_exp()
+    {
+        for (const double x : { 1.0 / 255.0, 0.01, 0.25, 0.5, 0.75, 0.999, 1.0, 2.0, 255.0 })
+        {
+            CHECK(std::fabs(blinkstick::detail::log(x) - std::log(x)) <= 1e-12 * std::fmax(1.0, std::fabs(std::log(x))));
+        }
+        for (const double y : { -12.2, -5.5, -1.0, -0.1, 0.0, 0.3, 1.0, 4.0 })
+        {
+            CHECK(std::fabs(blinkstick::detail::exp(y) - std::exp(y)) <= 1e-12 * std::exp(y));
+        }
+    }
+
+    void test_correction()
+    {
+        const auto correction = blinkstick::make_correction(blinkstick::gamma_2_2, { 255, 128, 0 });
+        for (int i = 0; i < 256; ++i)
+        {
+            CHECK(correction.red[i] == blinkstick::gamma_2_2[i]);
+            CHECK(correction.green[i] == (blinkstick::gamma_2_2[i] * 129) >> 8);
+            CHECK(correction.blue[i] == blinkstick::gamma_2_2[i] >> 8);
+        }
+    }
+}
+
+int main()
+{
+    test_gamma_matches_pow();
+    test_log_and_exp();
+    test_correction();
+    return check::result();
+}
@@ -0,0 +1,107 @@
+#include "check.hpp"
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/simulator.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // 32 LEDs go out in report 8, single LEDs in report 5
+    constexpr uint8_t BULK = 8;
+    constexpr uint8_t INDEXED = 5;
+
+    struct counts
+    {
+        uint64_t bulk;
+        uint64_t indexed;
+    };
+
+    counts reports(const blinkstick::simulator& sim)
+    {
+        return { sim.report_count(BULK), sim.report_count(INDEXED) + sim.report_count(1) };
+    }
+
+    std::vector<blinkstick::colour> frame(const uint8_t base)
+    {
+        std::vector<blinkstick::colour> colours(32);
+        for (size_t i = 0; i < colours.size(); ++i)
+        {
+            colours[i] = { base, static_cast<uint8_t>(i), 0 };
+        }
+        return colours;
+    }
+
+    void test_delta_encoding()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 32);
+        blinkstick::device target(sim, blinkstick::device_type::flex);
+        target.set_delta_encoding(true);
+
+        auto colours = frame(1);
+        CHECK(target.set_colours(0, colours));
+        auto before = reports(*sim);
+        CHECK(before.bulk == 1 && before.indexed == 0);
+
+        // Nothing changed, nothing is sent
+        CHECK(target.set_colours(0, colours));
+        auto after = reports(*sim);
+        CHECK(after.bulk == before.bulk && after.indexed == before.indexed);
+
+        // A few changes go out one LED at a time
+        colours[3].blue = 9;
+        colours[10].blue = 9;
+        CHECK(target.set_colours(0, colours));
+        after = reports(*sim);
+        CHECK(after.bulk == before.bulk);
+        CHECK(after.indexed == before.indexed + 2);
+        CHECK((sim->get_colour(0, 10) == colours[10]));
+
+        // Seven indexed reports still cost fewer bytes than one 32 LED report, eight do not
+        before = after;
+        for (size_t i = 0; i < 7; ++i)
+        {
+            colours[i * 4].green = 200;
+        }
+        CHECK(target.set_colours(0, colours));
+        after = reports(*sim);
+        CHECK(after.bulk == before.bulk && after.indexed == before.indexed + 7);
+
+        before = after;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            colours[i * 4].green = 100;
+        }
+        CHECK(target.set_colours(0, colours));
+        after = reports(*sim);
+        CHECK(after.bulk == before.bulk + 1 && after.indexed == before.indexed);
+
+        // A dense change uses the bulk report
+        before = after;
+        colours = frame(2);
+        CHECK(target.set_colours(0, colours));
+        after = reports(*sim);
+        CHECK(after.bulk == before.bulk + 1 && after.indexed == before.indexed);
+        const auto leds = sim->get_colours(0);
+        CHECK(std::vector<blinkstick::colour>(leds.begin(), leds.begin() + 32) == colours);
+    }
+
+    void test_disabled_by_default()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 32);
+        const blinkstick::device target(sim, blinkstick::device_type::flex);
+
+        const auto colours = frame(1);
+        CHECK(target.set_colours(0, colours));
+        CHECK(target.set_colours(0, colours));
+        CHECK(sim->report_count(BULK) == 2);
+    }
+}
+
+int main()
+{
+    test_delta_encoding();
+    test_disabled_by_default();
+    return check::result();
+}
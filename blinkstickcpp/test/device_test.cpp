@@ -0,0 +1,60 @@
+#include "check.hpp"
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/simulator.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    static_assert(
+        std::is_constructible_v<blinkstick::device, std::nullptr_t, blinkstick::device_type>,
+        "device{ nullptr, type } must pick a single constructor");
+
+    void test_null_device()
+    {
+        const blinkstick::device none{ nullptr, blinkstick::device_type::unknown };
+        CHECK(!none.is_valid());
+        CHECK(!none.set_colours(0, 1, 2, 3));
+        CHECK(none.get_type() == blinkstick::device_type::unknown);
+    }
+
+    void test_copies_share_state()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 24);
+        blinkstick::device original(sim, blinkstick::device_type::flex);
+        blinkstick::device copy = original;
+        CHECK(copy.get_id() == original.get_id());
+
+        // The LED count is queried once for both
+        CHECK(original.get_led_count() == 24);
+        CHECK(copy.get_led_count() == 24);
+        CHECK(sim->report_count(0x81) == 1);
+
+        copy.set_brightness(128);
+        CHECK(original.get_brightness() == 128);
+
+        // A frame written through one copy is served to the other without reading the device
+        const std::vector<blinkstick::colour> frame(24, blinkstick::colour{ 1, 2, 3 });
+        CHECK(original.set_colours(0, frame));
+        CHECK((copy.get_colour(0, 5) == blinkstick::colour{ 1, 2, 3 }));
+        CHECK(sim->report_count(1) == 0);
+
+        // A second device on the same transport starts from scratch
+        const blinkstick::device other(sim, blinkstick::device_type::flex);
+        CHECK(other.get_id() != original.get_id());
+        CHECK(other.get_brightness() == 255);
+        CHECK(other.get_led_count() == 24);
+        CHECK(sim->report_count(0x81) == 2);
+    }
+}
+
+int main()
+{
+    test_null_device();
+    test_copies_share_state();
+    return check::result();
+}
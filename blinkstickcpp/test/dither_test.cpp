@@ -0,0 +1,64 @@
+#include "check.hpp"
+
+#include <blinkstick/dither.hpp>
+
+#include <vector>
+
+namespace
+{
+    // Enough values for a full AVX2 block, an SSE2 block and a scalar tail
+    constexpr size_t LEDS = 37;
+    constexpr int FRAMES = 512;
+
+    void test_widened_colour_is_exact()
+    {
+        const std::vector<blinkstick::colour> colours = {
+            { 0, 0, 0 }, { 1, 2, 3 }, { 127, 128, 129 }, { 200, 100, 50 }, { 254, 255, 253 }, { 255, 255, 255 }
+        };
+
+        for (const auto& value : colours)
+        {
+            blinkstick::dithered_framebuffer frame(LEDS);
+            frame.fill(blinkstick::widen(value));
+
+            bool exact = true;
+            for (int f = 0; f < FRAMES; ++f)
+            {
+                for (const auto& out : frame.quantise())
+                {
+                    exact = exact && out == value;
+                }
+            }
+            CHECK(exact);
+        }
+    }
+
+    void test_dithering_averages_out()
+    {
+        // Half way between 200 and 201
+        blinkstick::dithered_framebuffer frame(LEDS);
+        frame.fill(blinkstick::colour16{ 200 * 256 + 128, 200 * 256 + 128, 200 * 256 + 128 });
+
+        std::vector<unsigned> sums(LEDS, 0);
+        for (int f = 0; f < 256; ++f)
+        {
+            const auto& out = frame.quantise();
+            for (size_t i = 0; i < LEDS; ++i)
+            {
+                CHECK(out[i].red == 200 || out[i].red == 201);
+                sums[i] += out[i].red;
+            }
+        }
+        for (const auto sum : sums)
+        {
+            CHECK(sum == 200 * 256 + 127 || sum == 200 * 256 + 128);
+        }
+    }
+}
+
+int main()
+{
+    test_widened_colour_is_exact();
+    test_dithering_averages_out();
+    return check::result();
+}
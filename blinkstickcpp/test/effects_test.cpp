@@ -0,0 +1,262 @@
+#include "check.hpp"
+
+#include <blinkstick/effects.hpp>
+#include <blinkstick/simulator.hpp>
+#include <blinkstick/transport.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using blinkstick::colour;
+    using std::chrono::milliseconds;
+    using std::chrono::nanoseconds;
+
+    std::vector<colour> draw(blinkstick::effect& animation, const nanoseconds elapsed, const size_t count)
+    {
+        std::vector<colour> frame(count);
+        animation.render(elapsed, frame.data(), frame.size());
+        return frame;
+    }
+
+    std::vector<colour> leds(const blinkstick::simulator& sim, const size_t count)
+    {
+        auto colours = sim.get_colours(0);
+        colours.resize(count);
+        return colours;
+    }
+
+    // Holds every send until released, so a frame can be caught in the middle of a transfer
+    class gated_transport : public blinkstick::transport
+    {
+    public:
+        bool send_feature_report(const uint8_t*, size_t) override
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ++waiting;
+            changed.notify_all();
+            changed.wait(lock, [this] { return open; });
+            return true;
+        }
+
+        bool get_feature_report(uint8_t*, size_t) override
+        {
+            return true;
+        }
+
+        bool wait_for_send()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            return changed.wait_for(lock, std::chrono::seconds(10), [this] { return waiting > 0; });
+        }
+
+        void release()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            open = true;
+            changed.notify_all();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable changed;
+        int waiting = 0;
+        bool open = false;
+    };
+
+    void test_solid_and_fade()
+    {
+        const colour red{ 255, 0, 0 };
+        const colour blue{ 0, 0, 255 };
+
+        blinkstick::solid_effect solid(red);
+        CHECK(draw(solid, nanoseconds(123), 5) == std::vector<colour>(5, red));
+
+        blinkstick::fade_effect fade(red, blue, milliseconds(100));
+        CHECK(draw(fade, nanoseconds(0), 3) == std::vector<colour>(3, red));
+        CHECK(draw(fade, milliseconds(50), 3) == std::vector<colour>(3, colour{ 128, 0, 127 }));
+        CHECK(draw(fade, milliseconds(100), 3) == std::vector<colour>(3, blue));
+        CHECK(draw(fade, milliseconds(500), 3) == std::vector<colour>(3, blue));
+
+        blinkstick::fade_effect instant(red, blue, nanoseconds(0));
+        CHECK(draw(instant, nanoseconds(0), 1) == std::vector<colour>(1, blue));
+    }
+
+    void test_pulse()
+    {
+        const colour white{ 255, 255, 255 };
+        blinkstick::pulse_effect pulse(white, milliseconds(100));
+
+        // Dark at the start of every period and at full brightness half way through
+        CHECK(draw(pulse, nanoseconds(0), 2) == std::vector<colour>(2, colour{}));
+        CHECK(draw(pulse, milliseconds(50), 2) == std::vector<colour>(2, white));
+        CHECK(draw(pulse, milliseconds(200), 2) == std::vector<colour>(2, colour{}));
+        CHECK(draw(pulse, milliseconds(25), 1)[0].red > 100);
+        CHECK(draw(pulse, milliseconds(25), 1)[0].red < 155);
+    }
+
+    void test_rainbow()
+    {
+        blinkstick::rainbow_effect rainbow(milliseconds(100));
+        const auto start = draw(rainbow, nanoseconds(0), 4);
+        for (size_t i = 0; i < start.size(); ++i)
+        {
+            CHECK(start[i] == blinkstick::hsv_to_rgb(blinkstick::hsv{ static_cast<uint8_t>(i * 64), 255, 255 }));
+        }
+
+        // A quarter turn moves every hue on by one LED
+        const auto quarter = draw(rainbow, milliseconds(25), 4);
+        for (size_t i = 0; i + 1 < start.size(); ++i)
+        {
+            CHECK(quarter[i] == start[i + 1]);
+        }
+        CHECK(quarter[3] == start[0]);
+    }
+
+    void test_chase()
+    {
+        const colour white{ 255, 255, 255 };
+        const colour black{};
+        blinkstick::chase_effect chase(white, black, milliseconds(80), 3);
+
+        // The head starts on the first LED, with the tail wrapping around the end
+        auto frame = draw(chase, nanoseconds(0), 8);
+        CHECK(frame[0] == white);
+        CHECK(frame[7] == (colour{ 170, 170, 170 }));
+        CHECK(frame[6] == (colour{ 85, 85, 85 }));
+        for (size_t i = 1; i < 6; ++i)
+        {
+            CHECK(frame[i] == black);
+        }
+
+        // One LED further along every period / count
+        frame = draw(chase, milliseconds(10), 8);
+        CHECK(frame[1] == white);
+        CHECK(frame[0] == (colour{ 170, 170, 170 }));
+        CHECK(frame[7] == (colour{ 85, 85, 85 }));
+
+        CHECK(draw(chase, nanoseconds(0), 0).empty());
+    }
+
+    void test_twinkle()
+    {
+        const colour green{ 0, 255, 0 };
+
+        blinkstick::twinkle_effect never(green, 0, milliseconds(100));
+        CHECK(draw(never, milliseconds(1000), 16) == std::vector<colour>(16, colour{}));
+
+        // At full density every LED sparks, then fades out over the decay time
+        blinkstick::twinkle_effect always(green, 65535, milliseconds(100));
+        CHECK(draw(always, milliseconds(1000), 16) == std::vector<colour>(16, green));
+
+        // The same seed gives the same sparks
+        blinkstick::twinkle_effect first(green, 2000, milliseconds(100), 7);
+        blinkstick::twinkle_effect second(green, 2000, milliseconds(100), 7);
+        for (int frame = 1; frame <= 20; ++frame)
+        {
+            CHECK(draw(first, milliseconds(frame * 10), 32) == draw(second, milliseconds(frame * 10), 32));
+        }
+    }
+
+    void test_frame_clock()
+    {
+        blinkstick::frame_clock clock(100);
+        CHECK(clock.interval() == milliseconds(10));
+
+        const auto first = clock.wait();
+        const auto second = clock.wait();
+        CHECK(second - first == milliseconds(10));
+        CHECK(clock.missed() == 0);
+
+        // Oversleeping skips the ticks that already passed but keeps the rest on the same grid
+        std::this_thread::sleep_for(milliseconds(55));
+        const auto late = clock.wait();
+        CHECK(clock.missed() >= 4);
+        CHECK((late - first) % milliseconds(10) == nanoseconds(0));
+        CHECK(late - second >= milliseconds(50));
+    }
+
+    void test_engine()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 8);
+        const blinkstick::device target(sim, blinkstick::device_type::flex);
+        blinkstick::effects_engine engine;
+
+        const colour red{ 255, 0, 0 };
+        const auto id = engine.add(target, 0, 8, std::make_shared<blinkstick::solid_effect>(red));
+        CHECK(engine.size() == 1);
+
+        const auto now = std::chrono::steady_clock::now();
+        engine.render(now);
+        CHECK(leds(*sim, 8) == std::vector<colour>(8, red));
+
+        // Unchanged frames are not sent again
+        engine.render(now + milliseconds(10));
+        auto stats = engine.get_stats();
+        CHECK(stats.frames == 2);
+        CHECK(stats.submitted == 1);
+        CHECK(stats.unchanged == 1);
+
+        // A failed frame is retried on the next one
+        sim->set_profile(blinkstick::report_profile{ {}, {}, 1.0 });
+        CHECK(engine.remove(id));
+        CHECK(!engine.remove(id));
+        const auto fade = engine.add(target, 0, 8, std::make_shared<blinkstick::fade_effect>(red, colour{}, milliseconds(0)));
+        engine.render(now + milliseconds(20));
+        CHECK(engine.get_stats().failed == 1);
+        sim->set_profile(blinkstick::report_profile{});
+        engine.render(now + milliseconds(30));
+        CHECK(engine.get_stats().submitted == 2);
+        CHECK(leds(*sim, 8) == std::vector<colour>(8, colour{}));
+        CHECK(engine.remove(fade));
+        CHECK(engine.size() == 0);
+    }
+
+    void test_engine_sends_outside_lock()
+    {
+        auto gate = std::make_shared<gated_transport>();
+        blinkstick::effects_engine engine;
+        engine.add(blinkstick::device(gate, blinkstick::device_type::basic), 0, 1,
+            std::make_shared<blinkstick::solid_effect>(colour{ 1, 2, 3 }));
+
+        auto frame = std::async(std::launch::async, [&] { engine.render(std::chrono::steady_clock::now()); });
+        CHECK(gate->wait_for_send());
+
+        // With a transfer in flight, the list can still be changed
+        auto edits = std::async(std::launch::async, [&] {
+            const auto id = engine.add(blinkstick::device(nullptr, blinkstick::device_type::basic), 0, 1, nullptr);
+            return engine.size() == 2 && engine.remove(id);
+        });
+        const bool finished = edits.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+        CHECK(finished);
+        gate->release();
+        if (!finished)
+        {
+            // add() is stuck behind the frame for good
+            std::_Exit(check::result());
+        }
+        CHECK(edits.get());
+        frame.get();
+        CHECK(engine.get_stats().submitted == 1);
+    }
+}
+
+int main()
+{
+    test_solid_and_fade();
+    test_pulse();
+    test_rainbow();
+    test_chase();
+    test_twinkle();
+    test_frame_clock();
+    test_engine();
+    test_engine_sends_outside_lock();
+    return check::result();
+}
@@ -0,0 +1,93 @@
+#include "check.hpp"
+
+#include <blinkstick/group_commit.hpp>
+#include <blinkstick/transport.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    // Holds every report until released, so a frame can be kept in flight past a commit's deadline
+    class gated_transport : public blinkstick::transport
+    {
+    public:
+        bool send_feature_report(const uint8_t*, size_t) override
+        {
+            const int now = ++concurrent;
+            if (now > peak)
+            {
+                peak = now;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            released.wait(lock, [this] { return open; });
+            --concurrent;
+            return true;
+        }
+
+        bool get_feature_report(uint8_t*, size_t) override
+        {
+            return true;
+        }
+
+        void release()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                open = true;
+            }
+            released.notify_all();
+        }
+
+        std::atomic<int> concurrent{ 0 };
+        std::atomic<int> peak{ 0 };
+
+    private:
+        std::mutex mutex;
+        std::condition_variable released;
+        bool open = false;
+    };
+
+    void test_busy_device_is_dropped()
+    {
+        auto io = std::make_shared<gated_transport>();
+        const blinkstick::device target(io, blinkstick::device_type::basic);
+        blinkstick::group_committer committer(4);
+
+        const auto soon = [] { return std::chrono::steady_clock::now() + std::chrono::milliseconds(20); };
+        const auto first = committer.commit({ { target, 0, { { 1, 2, 3 } } } }, soon());
+        CHECK(first.timed_out == 1);
+
+        // The first frame is still stuck in the transport, so the device must not be sent to again
+        const auto second = committer.commit({ { target, 0, { { 4, 5, 6 } } } }, soon());
+        CHECK(second.dropped == 1);
+        CHECK(second.status.size() == 1 && second.status[0] == blinkstick::frame_status::dropped);
+        CHECK(io->peak == 1);
+
+        // Once the stuck frame finishes the device takes frames again
+        io->release();
+        blinkstick::commit_result third;
+        for (int attempt = 0; attempt < 1000; ++attempt)
+        {
+            third = committer.commit({ { target, 0, { { 7, 8, 9 } } } });
+            if (third.dropped == 0)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(third.sent == 1);
+        CHECK(io->peak == 1);
+    }
+}
+
+int main()
+{
+    test_busy_device_is_dropped();
+    return check::result();
+}
@@ -0,0 +1,172 @@
+#include "check.hpp"
+#include "hidraw.hpp"
+
+#include <blinkstick/hidraw_transport.hpp>
+
+#include <linux/hidraw.h>
+#include <sys/ioctl.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+    // Everything the transport handed to the last ioctl
+    struct ioctl_call
+    {
+        int fd = 0;
+        unsigned long request = 0;
+        void* arg = nullptr;
+        std::vector<uint8_t> sent;
+        int result = 0;
+    };
+
+    ioctl_call last_call;
+
+    int fake_ioctl(const int fd, const unsigned long request, void* arg)
+    {
+        last_call.fd = fd;
+        last_call.request = request;
+        last_call.arg = arg;
+
+        auto* bytes = static_cast<uint8_t*>(arg);
+        const auto size = _IOC_SIZE(request);
+        if (_IOC_NR(request) == _IOC_NR(HIDIOCSFEATURE(0)))
+        {
+            last_call.sent.assign(bytes, bytes + size);
+        }
+        else
+        {
+            // Answer a get with the report ID the caller asked for followed by a counting pattern
+            for (size_t i = 1; i < size; ++i)
+            {
+                bytes[i] = static_cast<uint8_t>(i);
+            }
+        }
+        return last_call.result;
+    }
+
+    void test_send_feature_report()
+    {
+        blinkstick::hidraw_transport io(-1, fake_ioctl);
+        last_call = {};
+
+        const uint8_t report[] = { 1, 0x10, 0x20, 0x30 };
+        CHECK(io.send_feature_report(report, sizeof(report)));
+        CHECK(last_call.fd == -1);
+        CHECK(last_call.request == HIDIOCSFEATURE(sizeof(report)));
+        CHECK(_IOC_SIZE(last_call.request) == sizeof(report));
+        CHECK(_IOC_DIR(last_call.request) == (_IOC_READ | _IOC_WRITE));
+        CHECK(_IOC_TYPE(last_call.request) == 'H');
+        CHECK(last_call.arg == report);
+        CHECK(last_call.sent == std::vector<uint8_t>(report, report + sizeof(report)));
+
+        // The size travels in the request, so a larger report must produce a different one
+        std::vector<uint8_t> bulk(64 * 3 + 2, 0);
+        bulk[0] = 9;
+        CHECK(io.send_feature_report(bulk.data(), bulk.size()));
+        CHECK(last_call.request == HIDIOCSFEATURE(bulk.size()));
+        CHECK(_IOC_SIZE(last_call.request) == bulk.size());
+        CHECK(last_call.sent == bulk);
+    }
+
+    void test_get_feature_report()
+    {
+        blinkstick::hidraw_transport io(-1, fake_ioctl);
+        last_call = {};
+
+        uint8_t report[33] = { 7 };
+        CHECK(io.get_feature_report(report, sizeof(report)));
+        CHECK(last_call.request == HIDIOCGFEATURE(sizeof(report)));
+        CHECK(_IOC_SIZE(last_call.request) == sizeof(report));
+        CHECK(_IOC_DIR(last_call.request) == (_IOC_READ | _IOC_WRITE));
+        CHECK(last_call.arg == report);
+        CHECK(report[0] == 7);
+        CHECK(report[1] == 1);
+        CHECK(report[32] == 32);
+    }
+
+    void test_failed_ioctl()
+    {
+        blinkstick::hidraw_transport io(-1, fake_ioctl);
+        last_call = {};
+        last_call.result = -1;
+
+        uint8_t report[4] = { 1 };
+        CHECK(!io.send_feature_report(report, sizeof(report)));
+        CHECK(!io.get_feature_report(report, sizeof(report)));
+    }
+
+    void write_file(const std::filesystem::path& path, const std::string& contents)
+    {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path) << contents;
+    }
+
+    // Lays out a hidraw node the way sysfs does: the class entry links to the hid device, whose
+    // grandparent is the usb device carrying bcdDevice
+    void add_node(
+        const std::filesystem::path& root,
+        const std::string& name,
+        const std::string& hid_id,
+        const std::string& serial,
+        const std::string& bcd)
+    {
+        const auto usb = root / "devices" / ("usb-" + name);
+        const auto hid = usb / "interface" / ("0003:" + name);
+        write_file(usb / "bcdDevice", bcd + "\n");
+        write_file(hid / "uevent", "DRIVER=hid-generic\nHID_ID=" + hid_id + "\nHID_NAME=BlinkStick\nHID_UNIQ=" + serial + "\n");
+
+        const auto entry = root / "class" / name;
+        std::filesystem::create_directories(entry);
+        std::filesystem::create_directory_symlink(hid, entry / "device");
+    }
+
+    void test_sysfs_discovery()
+    {
+        char pattern[] = "/tmp/blinkstick-sysfs-XXXXXX";
+        const std::filesystem::path root = ::mkdtemp(pattern);
+        const auto class_dir = (root / "class").string();
+
+        add_node(root, "hidraw0", "0003:0000046D:0000C52B", "", "1201");
+        add_node(root, "hidraw3", "0003:000020A0:000041E5", "BS000001-3.0", "0203");
+        add_node(root, "hidraw4", "0003:000020A0:000041E5", "BS000002-2.1", "0100");
+
+        auto devices = blinkstick::enumerate_hidraw(class_dir);
+        std::sort(devices.begin(), devices.end(), [](const auto& lhs, const auto& rhs) { return lhs.path < rhs.path; });
+        CHECK(devices.size() == 2);
+        if (devices.size() == 2)
+        {
+            CHECK(devices[0].path == "/dev/hidraw3");
+            CHECK(devices[0].serial == "BS000001-3.0");
+            CHECK(devices[0].type == blinkstick::device_type::flex);
+            CHECK(devices[1].path == "/dev/hidraw4");
+            CHECK(devices[1].serial == "BS000002-2.1");
+            CHECK(devices[1].type == blinkstick::device_type::pro);
+        }
+
+        blinkstick::device_info info;
+        CHECK(blinkstick::describe_hidraw("hidraw3", info, class_dir));
+        CHECK(info.path == "/dev/hidraw3");
+        CHECK(info.serial == "BS000001-3.0");
+        CHECK(info.type == blinkstick::device_type::flex);
+
+        CHECK(!blinkstick::describe_hidraw("hidraw0", info, class_dir));
+        CHECK(!blinkstick::describe_hidraw("hidraw9", info, class_dir));
+        CHECK(blinkstick::enumerate_hidraw((root / "missing").string()).empty());
+
+        std::filesystem::remove_all(root);
+    }
+}
+
+int main()
+{
+    test_send_feature_report();
+    test_get_feature_report();
+    test_failed_ioctl();
+    test_sysfs_discovery();
+    return check::result();
+}
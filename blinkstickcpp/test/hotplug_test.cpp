@@ -0,0 +1,201 @@
+#include "check.hpp"
+
+#include <blinkstick/hotplug.hpp>
+#include <blinkstick/simulator.hpp>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr const char* DEVPATH = "/devices/pci0000:00/0000:00:14.0/usb1/1-2/1-2:1.0/0003:20A0:41E5.0004/hidraw/hidraw3";
+
+    // Leaves the monitor thread idle so the test can feed events through handle() itself
+    class silent_source : public blinkstick::uevent_source
+    {
+    public:
+        std::optional<blinkstick::uevent> receive(const std::chrono::milliseconds timeout) override
+        {
+            std::this_thread::sleep_for(timeout);
+            return std::nullopt;
+        }
+    };
+
+    std::vector<char> properties(const std::string& action, const std::string& devpath, const std::string& devname)
+    {
+        std::vector<char> message;
+        for (const auto& property :
+             { "ACTION=" + action, "DEVPATH=" + devpath, std::string("SUBSYSTEM=hidraw"), "DEVNAME=" + devname, std::string("SEQNUM=42") })
+        {
+            message.insert(message.end(), property.begin(), property.end());
+            message.push_back('\0');
+        }
+        return message;
+    }
+
+    // "action@devpath\0KEY=value\0...", as sent by the kernel
+    std::vector<char> kernel_message(const std::string& action, const std::string& devpath)
+    {
+        const auto header = action + "@" + devpath;
+        std::vector<char> message(header.begin(), header.end());
+        message.push_back('\0');
+        const auto list = properties(action, devpath, "hidraw3");
+        message.insert(message.end(), list.begin(), list.end());
+        return message;
+    }
+
+    // The binary header libudev puts in front of the properties it re-broadcasts
+    std::vector<char> udev_message(const std::string& action, const std::string& devpath, const bool valid_magic = true)
+    {
+        const auto list = properties(action, devpath, "/dev/hidraw3");
+        std::vector<char> message(40, '\0');
+        std::memcpy(message.data(), "libudev", 8);
+        const unsigned char magic[] = { 0xfe, 0xed, 0xca, static_cast<unsigned char>(valid_magic ? 0xfe : 0x00) };
+        std::memcpy(message.data() + 8, magic, sizeof(magic));
+        const unsigned sizes[] = { 40, 40, static_cast<unsigned>(list.size()) };
+        std::memcpy(message.data() + 12, sizes, sizeof(sizes));
+        message.insert(message.end(), list.begin(), list.end());
+        return message;
+    }
+
+    std::optional<blinkstick::uevent> parse(const std::vector<char>& message)
+    {
+        return blinkstick::netlink_uevent_source::parse(message.data(), message.size());
+    }
+
+    void test_parse()
+    {
+        const auto kernel = parse(kernel_message("add", DEVPATH));
+        CHECK(kernel.has_value());
+        if (kernel)
+        {
+            CHECK(kernel->action == "add");
+            CHECK(kernel->devpath == DEVPATH);
+            CHECK(kernel->subsystem == "hidraw");
+            CHECK(kernel->devname == "hidraw3");
+        }
+
+        const auto udev = parse(udev_message("remove", DEVPATH));
+        CHECK(udev.has_value());
+        if (udev)
+        {
+            CHECK(udev->action == "remove");
+            CHECK(udev->devpath == DEVPATH);
+            CHECK(udev->devname == "hidraw3");
+        }
+
+        CHECK(!parse(udev_message("add", DEVPATH, false)).has_value());
+
+        const std::vector<char> garbage = { 'n', 'o', 't', ' ', 'a', 'n', ' ', 'e', 'v', 'e', 'n', 't' };
+        CHECK(!parse(garbage).has_value());
+    }
+
+    void test_events_update_registry()
+    {
+        blinkstick::simulator::unplug_all();
+        blinkstick::registry devices(blinkstick::backend::simulator);
+        blinkstick::hotplug_monitor monitor(devices, std::make_unique<silent_source>());
+
+        std::vector<blinkstick::hotplug_event> events;
+        monitor.subscribe([&](const blinkstick::hotplug_event& event) { events.push_back(event); });
+
+        // Not a BlinkStick, so ignored
+        blinkstick::simulator::plug(std::make_shared<blinkstick::simulator>());
+        monitor.handle(*parse(kernel_message("add", "/devices/usb1/1-3/1-3:1.0/0003:046D:C52B.0001/hidraw/hidraw3")));
+        CHECK(events.empty());
+
+        // Neither are other actions or subsystems, which would otherwise re-enumerate and find the new device
+        monitor.handle(*parse(kernel_message("change", DEVPATH)));
+        monitor.handle(*parse(kernel_message("bind", DEVPATH)));
+        auto usb = *parse(kernel_message("add", DEVPATH));
+        usb.subsystem = "usb";
+        monitor.handle(usb);
+        CHECK(events.empty());
+        CHECK(devices.size() == 0);
+
+        // The vendor and product ids may be in lower case
+        auto lower = *parse(kernel_message("add", "/devices/usb1/1-2/1-2:1.0/0003:20a0:41e5.0004/hidraw/hidraw3"));
+        monitor.handle(lower);
+        CHECK(events.size() == 1);
+        CHECK(devices.size() == 1);
+        blinkstick::simulator::unplug_all();
+        monitor.handle(*parse(kernel_message("remove", DEVPATH)));
+        events.clear();
+        blinkstick::simulator::plug(std::make_shared<blinkstick::simulator>());
+
+        monitor.handle(*parse(kernel_message("add", DEVPATH)));
+        CHECK(events.size() == 1);
+        CHECK(devices.size() == 1);
+        if (events.size() == 1)
+        {
+            CHECK(events[0].type == blinkstick::hotplug_event::kind::added);
+            CHECK(events[0].info.path == "simulator:0");
+        }
+
+        blinkstick::simulator::unplug_all();
+        monitor.handle(*parse(udev_message("remove", DEVPATH)));
+        CHECK(events.size() == 2);
+        CHECK(devices.size() == 0);
+        if (events.size() == 2)
+        {
+            CHECK(events[1].type == blinkstick::hotplug_event::kind::removed);
+            CHECK(events[1].info.path == "simulator:0");
+        }
+    }
+
+    void test_hidraw_remove()
+    {
+        blinkstick::registry devices(blinkstick::backend::hidraw);
+        blinkstick::hotplug_monitor monitor(devices, std::make_unique<silent_source>());
+        CHECK(devices.add(blinkstick::device_info{ "/dev/hidraw3", "BS000001-3.0", blinkstick::device_type::flex }));
+
+        std::vector<blinkstick::hotplug_event> events;
+        monitor.subscribe([&](const blinkstick::hotplug_event& event) { events.push_back(event); });
+
+        monitor.handle(*parse(udev_message("remove", DEVPATH)));
+        CHECK(events.size() == 1);
+        if (events.size() == 1)
+        {
+            CHECK(events[0].type == blinkstick::hotplug_event::kind::removed);
+            CHECK(events[0].info.serial == "BS000001-3.0");
+        }
+        CHECK(devices.size() == 0);
+    }
+
+    void test_callback_can_resubscribe()
+    {
+        blinkstick::simulator::unplug_all();
+        blinkstick::registry devices(blinkstick::backend::simulator);
+        blinkstick::hotplug_monitor monitor(devices, std::make_unique<silent_source>());
+
+        // Would deadlock if callbacks were called with the subscriber list locked
+        int once = 0;
+        int later = 0;
+        int id = -1;
+        id = monitor.subscribe([&](const blinkstick::hotplug_event&) {
+            ++once;
+            monitor.unsubscribe(id);
+            monitor.subscribe([&](const blinkstick::hotplug_event&) { ++later; });
+        });
+
+        blinkstick::simulator::plug(std::make_shared<blinkstick::simulator>());
+        monitor.handle(*parse(kernel_message("add", DEVPATH)));
+        blinkstick::simulator::unplug_all();
+        monitor.handle(*parse(kernel_message("remove", DEVPATH)));
+
+        CHECK(once == 1);
+        CHECK(later == 1);
+    }
+}
+
+int main()
+{
+    test_parse();
+    test_events_update_registry();
+    test_hidraw_remove();
+    test_callback_can_resubscribe();
+    return check::result();
+}
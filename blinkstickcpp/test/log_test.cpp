@@ -0,0 +1,78 @@
+#include "check.hpp"
+
+#include <blinkstick/log.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::atomic<uint64_t> received{ 0 };
+
+    void test_flush_delivers_everything()
+    {
+        constexpr int threads = 4;
+        constexpr int records = 5000;
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t)
+        {
+            writers.emplace_back([t] {
+                for (int i = 0; i < records; ++i)
+                {
+                    BLINKSTICK_LOG(blinkstick::log_level::info, "record", blinkstick::log_field("thread", t));
+                }
+            });
+        }
+        for (auto& writer : writers)
+        {
+            writer.join();
+        }
+
+        blinkstick::flush_log();
+        CHECK(received + blinkstick::dropped_log_records() == threads * records);
+    }
+
+    void test_idle_logger_wakes_up()
+    {
+        // Long enough for the logging thread to park
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        const auto before = received.load();
+        BLINKSTICK_LOG(blinkstick::log_level::info, "after idle");
+        blinkstick::flush_log();
+        CHECK(received == before + 1);
+    }
+
+    void test_sink_reentry()
+    {
+        // A sink that flushes, then replaces itself, must not deadlock the logging thread
+        std::atomic<int> reentrant{ 0 };
+        blinkstick::set_log_sink([&](const blinkstick::log_record&) {
+            ++reentrant;
+            blinkstick::flush_log();
+            blinkstick::set_log_sink([](const blinkstick::log_record&) { ++received; });
+        });
+
+        const auto before = received.load();
+        BLINKSTICK_LOG(blinkstick::log_level::info, "first");
+        BLINKSTICK_LOG(blinkstick::log_level::info, "second");
+        blinkstick::flush_log();
+        CHECK(reentrant == 1);
+        CHECK(received == before + 1);
+    }
+}
+
+int main()
+{
+    blinkstick::set_log_sink([](const blinkstick::log_record&) { ++received; });
+    blinkstick::set_log_level(blinkstick::log_level::info);
+
+    test_flush_delivers_everything();
+    test_idle_logger_wakes_up();
+    test_idle_logger_wakes_up();
+    test_sink_reentry();
+    return check::result();
+}
@@ -0,0 +1,135 @@
+#include "check.hpp"
+
+#include <blinkstick/metrics.hpp>
+#include <blinkstick/simulator.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    blinkstick::device idle_device()
+    {
+        return blinkstick::device(
+            std::make_shared<blinkstick::simulator>(blinkstick::device_type::strip, 8), blinkstick::device_type::strip);
+    }
+
+    bool contains(const std::string& text, const std::string& line)
+    {
+        return text.find(line + "\n") != std::string::npos;
+    }
+
+    std::string read_file(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void test_golden()
+    {
+        // Idle devices keep every value, including the latency quantiles, at zero
+        const auto text = blinkstick::render_openmetrics({
+            blinkstick::metrics_source{ "desk \"left\"", idle_device() },
+            blinkstick::metrics_source{ "SIM2", idle_device() },
+        });
+
+        const std::string expected =
+            "# TYPE blinkstick_frames counter\n"
+            "# HELP blinkstick_frames Frames written to the device.\n"
+            "blinkstick_frames_total{device=\"desk \\\"left\\\"\"} 0\n"
+            "blinkstick_frames_total{device=\"SIM2\"} 0\n"
+            "# TYPE blinkstick_sent_bytes counter\n"
+            "# HELP blinkstick_sent_bytes Feature report bytes sent to the device.\n"
+            "blinkstick_sent_bytes_total{device=\"desk \\\"left\\\"\"} 0\n"
+            "blinkstick_sent_bytes_total{device=\"SIM2\"} 0\n"
+            "# TYPE blinkstick_read_bytes counter\n"
+            "# HELP blinkstick_read_bytes Feature report bytes read from the device.\n"
+            "blinkstick_read_bytes_total{device=\"desk \\\"left\\\"\"} 0\n"
+            "blinkstick_read_bytes_total{device=\"SIM2\"} 0\n"
+            "# TYPE blinkstick_errors counter\n"
+            "# HELP blinkstick_errors Failed feature report transfers.\n"
+            "blinkstick_errors_total{device=\"desk \\\"left\\\"\"} 0\n"
+            "blinkstick_errors_total{device=\"SIM2\"} 0\n"
+            "# TYPE blinkstick_retries counter\n"
+            "# HELP blinkstick_retries Retried feature report transfers.\n"
+            "blinkstick_retries_total{device=\"desk \\\"left\\\"\"} 0\n"
+            "blinkstick_retries_total{device=\"SIM2\"} 0\n"
+            "# TYPE blinkstick_dropped_frames counter\n"
+            "# HELP blinkstick_dropped_frames Frames replaced by a newer frame before being sent.\n"
+            "blinkstick_dropped_frames_total{device=\"desk \\\"left\\\"\"} 0\n"
+            "blinkstick_dropped_frames_total{device=\"SIM2\"} 0\n"
+            "# TYPE blinkstick_transfer_latency_seconds summary\n"
+            "# HELP blinkstick_transfer_latency_seconds Time taken by a single feature report transfer.\n"
+            "blinkstick_transfer_latency_seconds{device=\"desk \\\"left\\\"\",direction=\"send\",quantile=\"0.5\"} 0\n"
+            "blinkstick_transfer_latency_seconds{device=\"desk \\\"left\\\"\",direction=\"send\",quantile=\"0.99\"} 0\n"
+            "blinkstick_transfer_latency_seconds_sum{device=\"desk \\\"left\\\"\",direction=\"send\"} 0\n"
+            "blinkstick_transfer_latency_seconds_count{device=\"desk \\\"left\\\"\",direction=\"send\"} 0\n"
+            "blinkstick_transfer_latency_seconds{device=\"SIM2\",direction=\"send\",quantile=\"0.5\"} 0\n"
+            "blinkstick_transfer_latency_seconds{device=\"SIM2\",direction=\"send\",quantile=\"0.99\"} 0\n"
+            "blinkstick_transfer_latency_seconds_sum{device=\"SIM2\",direction=\"send\"} 0\n"
+            "blinkstick_transfer_latency_seconds_count{device=\"SIM2\",direction=\"send\"} 0\n"
+            "blinkstick_transfer_latency_seconds{device=\"desk \\\"left\\\"\",direction=\"get\",quantile=\"0.5\"} 0\n"
+            "blinkstick_transfer_latency_seconds{device=\"desk \\\"left\\\"\",direction=\"get\",quantile=\"0.99\"} 0\n"
+            "blinkstick_transfer_latency_seconds_sum{device=\"desk \\\"left\\\"\",direction=\"get\"} 0\n"
+            "blinkstick_transfer_latency_seconds_count{device=\"desk \\\"left\\\"\",direction=\"get\"} 0\n"
+            "blinkstick_transfer_latency_seconds{device=\"SIM2\",direction=\"get\",quantile=\"0.5\"} 0\n"
+            "blinkstick_transfer_latency_seconds{device=\"SIM2\",direction=\"get\",quantile=\"0.99\"} 0\n"
+            "blinkstick_transfer_latency_seconds_sum{device=\"SIM2\",direction=\"get\"} 0\n"
+            "blinkstick_transfer_latency_seconds_count{device=\"SIM2\",direction=\"get\"} 0\n"
+            "# EOF\n";
+        CHECK(text == expected);
+    }
+
+    void test_counters()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::strip, 8);
+        const blinkstick::device target(sim, blinkstick::device_type::strip);
+        CHECK(target.set_colour(0, 0, 1, 2, 3));
+        CHECK(target.set_colour(0, 1, 1, 2, 3));
+        sim->set_profile(blinkstick::report_profile{ {}, {}, 1.0 });
+        CHECK(!target.set_colour(0, 2, 1, 2, 3));
+
+        const auto text = blinkstick::render_openmetrics({ blinkstick::metrics_source{ "SIM1", target } });
+        const auto sent = std::to_string(target.get_stats().bytes_sent);
+        CHECK(contains(text, "blinkstick_sent_bytes_total{device=\"SIM1\"} " + sent));
+        CHECK(contains(text, "blinkstick_errors_total{device=\"SIM1\"} 1"));
+        CHECK(contains(text, "blinkstick_transfer_latency_seconds_count{device=\"SIM1\",direction=\"send\"} 3"));
+        CHECK(contains(text, "blinkstick_transfer_latency_seconds_count{device=\"SIM1\",direction=\"get\"} 0"));
+        CHECK(text.size() >= 6 && text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+    }
+
+    void test_empty()
+    {
+        const auto text = blinkstick::render_openmetrics({});
+        CHECK(contains(text, "# TYPE blinkstick_frames counter"));
+        CHECK(contains(text, "# TYPE blinkstick_transfer_latency_seconds summary"));
+        CHECK(text.find("_total{") == std::string::npos);
+        CHECK(text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+    }
+
+    void test_write_file_atomically()
+    {
+        const std::string path = "metrics_test.prom";
+        CHECK(blinkstick::write_file_atomically(path, "first\n"));
+        CHECK(read_file(path) == "first\n");
+        CHECK(blinkstick::write_file_atomically(path, "second\n"));
+        CHECK(read_file(path) == "second\n");
+        CHECK(!std::ifstream(path + ".tmp").good());
+        std::remove(path.c_str());
+
+        CHECK(!blinkstick::write_file_atomically("missing-directory/metrics.prom", "text\n"));
+    }
+}
+
+int main()
+{
+    test_golden();
+    test_counters();
+    test_empty();
+    test_write_file_atomically();
+    return check::result();
+}
@@ -0,0 +1,108 @@
+#include "check.hpp"
+#include "packing.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using blinkstick::colour;
+    using blinkstick::packing::kernel;
+
+    constexpr uint8_t GUARD = 0xA5;
+
+    // Straight from the report layout, independent of every kernel
+    std::vector<uint8_t> reference(const std::vector<colour>& colours, const uint8_t brightness)
+    {
+        std::vector<uint8_t> out;
+        for (const auto& value : colours)
+        {
+            out.push_back(blinkstick::packing::scale(value.green, brightness));
+            out.push_back(blinkstick::packing::scale(value.red, brightness));
+            out.push_back(blinkstick::packing::scale(value.blue, brightness));
+        }
+        return out;
+    }
+
+    // Packs into a buffer with guard bytes after it, so a kernel writing past count * 3 is caught
+    template<typename Pack>
+    std::vector<uint8_t> packed(const std::vector<colour>& colours, Pack pack)
+    {
+        const size_t size = colours.size() * 3;
+        std::vector<uint8_t> out(size + 32, GUARD);
+        pack(colours.data(), colours.size(), out.data());
+        bool guarded = true;
+        for (size_t i = size; i < out.size(); ++i)
+        {
+            guarded = guarded && out[i] == GUARD;
+        }
+        CHECK(guarded);
+        out.resize(size);
+        return out;
+    }
+
+    void test_kernels_match_scalar()
+    {
+        std::mt19937 random(20);
+        std::vector<kernel> kernels = { kernel::scalar };
+        for (const kernel which : { kernel::ssse3, kernel::avx2 })
+        {
+            if (blinkstick::packing::supported(which))
+            {
+                kernels.push_back(which);
+            }
+        }
+        std::printf("checking %zu kernel(s), best is %d\n", kernels.size(), static_cast<int>(blinkstick::packing::best_kernel()));
+
+        for (size_t count = 0; count <= 70; ++count)
+        {
+            for (int round = 0; round < 8; ++round)
+            {
+                // Exactly count LEDs, so reads past the end land outside the allocation
+                std::vector<colour> colours(count);
+                for (auto& value : colours)
+                {
+                    value = colour{ static_cast<uint8_t>(random()), static_cast<uint8_t>(random()), static_cast<uint8_t>(random()) };
+                }
+
+                for (const int brightness : { 255, 0, 1, 128, 254, static_cast<int>(random() & 0xFF) })
+                {
+                    const auto level = static_cast<uint8_t>(brightness);
+                    const auto expected = reference(colours, level);
+
+                    const auto dispatched = packed(colours, [&](const colour* in, const size_t n, uint8_t* out) {
+                        blinkstick::packing::pack_grb(in, n, level, out);
+                    });
+                    CHECK(dispatched == expected);
+
+                    for (const kernel which : kernels)
+                    {
+                        const auto result = packed(colours, [&](const colour* in, const size_t n, uint8_t* out) {
+                            blinkstick::packing::pack_grb(which, in, n, level, out);
+                        });
+                        if (result != expected)
+                        {
+                            std::printf("kernel %d differs for %zu LEDs at brightness %d\n", static_cast<int>(which), count, brightness);
+                        }
+                        CHECK(result == expected);
+                    }
+                }
+            }
+        }
+    }
+
+    void test_best_kernel_is_supported()
+    {
+        CHECK(blinkstick::packing::supported(kernel::scalar));
+        CHECK(blinkstick::packing::supported(blinkstick::packing::best_kernel()));
+    }
+}
+
+int main()
+{
+    test_best_kernel_is_supported();
+    test_kernels_match_scalar();
+    return check::result();
+}
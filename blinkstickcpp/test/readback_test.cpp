@@ -0,0 +1,98 @@
+#include "check.hpp"
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/simulator.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+    std::vector<blinkstick::colour> gradient(const size_t count, const uint8_t base)
+    {
+        std::vector<blinkstick::colour> colours(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            colours[i] = { static_cast<uint8_t>(base + i), static_cast<uint8_t>(i), static_cast<uint8_t>(base) };
+        }
+        return colours;
+    }
+
+    void test_only_channel_zero_is_read_back()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::pro, 32);
+        const blinkstick::device target(sim, blinkstick::device_type::pro);
+
+        const auto first = gradient(32, 10);
+        const auto second = gradient(32, 100);
+        CHECK(target.set_colours(0, first));
+        CHECK(target.set_colours(1, second));
+
+        // Reading channel 1 would decode channel 0's LEDs, so it must fail and keep the copy
+        CHECK(!target.sync_colours(1));
+        CHECK(target.get_colour(1, 5) == second[5]);
+        CHECK(target.get_colours(1).empty());
+
+        CHECK(target.sync_colours(0));
+        CHECK(target.get_colour(0, 5) == first[5]);
+        CHECK(target.get_colours(0) == first);
+
+        // Without a host-side copy, only channel 0 falls back to the hardware
+        const blinkstick::device fresh(sim, blinkstick::device_type::pro);
+        const auto reads = sim->report_count(1) + sim->report_count(9);
+        CHECK(fresh.get_colour(1, 5) == blinkstick::colour{});
+        CHECK(sim->report_count(1) + sim->report_count(9) == reads);
+        CHECK(fresh.get_colour(0, 0) == first[0]);
+    }
+
+    void test_long_strip_reads_first_segment()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::pro, 192);
+        const blinkstick::device target(sim, blinkstick::device_type::pro);
+
+        const auto strip = gradient(192, 0);
+        CHECK(target.set_colours(0, strip));
+
+        const auto read = target.get_colours(0);
+        CHECK(read == std::vector<blinkstick::colour>(strip.begin(), strip.begin() + 64));
+        CHECK(target.get_colours(1).empty());
+    }
+
+    void test_long_strip_single_leds()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::pro, 192);
+        const blinkstick::device target(sim, blinkstick::device_type::pro);
+
+        const auto strip = gradient(192, 0);
+        CHECK(target.set_colours(0, strip));
+        CHECK(target.get_colour(0, 0) == strip[0]);
+        CHECK(target.get_colour(0, 63) == strip[63]);
+        CHECK(target.get_colour(0, 64) == strip[64]);
+        CHECK(target.get_colour(0, 100) == strip[100]);
+        CHECK(target.get_colour(0, 191) == strip[191]);
+
+        // Past the first segment there is nothing to read from the hardware
+        const blinkstick::device fresh(sim, blinkstick::device_type::pro);
+        CHECK(fresh.get_colour(0, 100) == blinkstick::colour{});
+        CHECK(sim->report_count(10) == 0);
+    }
+
+    void test_out_of_range_index_is_not_read()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 32);
+        const blinkstick::device target(sim, blinkstick::device_type::flex);
+
+        CHECK(target.get_colour(0, 100) == blinkstick::colour{});
+        CHECK(target.get_colour(0, -1) == blinkstick::colour{});
+        CHECK(sim->report_count(10) == 0);
+    }
+}
+
+int main()
+{
+    test_only_channel_zero_is_read_back();
+    test_long_strip_reads_first_segment();
+    test_long_strip_single_leds();
+    test_out_of_range_index_is_not_read();
+    return check::result();
+}
@@ -0,0 +1,96 @@
+#include "check.hpp"
+
+#include <blinkstick/registry.hpp>
+#include <blinkstick/simulator.hpp>
+
+#include <memory>
+
+namespace
+{
+    void plug(const int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            blinkstick::simulator::plug(std::make_shared<blinkstick::simulator>());
+        }
+    }
+
+    void test_lookup()
+    {
+        blinkstick::simulator::unplug_all();
+        plug(2);
+        blinkstick::registry devices(blinkstick::backend::simulator);
+        CHECK(devices.size() == 2);
+        CHECK(devices.get_backend() == blinkstick::backend::simulator);
+
+        const auto by_path = devices.get_by_path("simulator:1");
+        const auto by_serial = devices.get_by_serial("SIM1");
+        CHECK(by_path.is_valid());
+        CHECK(by_serial.is_valid());
+
+        // Both lookups hand out copies of the one open handle
+        CHECK(by_path.get_id() == by_serial.get_id());
+        CHECK(devices.get_by_path("simulator:0").get_id() != by_path.get_id());
+
+        CHECK(!devices.get_by_path("simulator:9").is_valid());
+        CHECK(!devices.get_by_serial("SIM9").is_valid());
+        CHECK(devices.open_all().size() == 2);
+    }
+
+    void test_refresh_keeps_handles()
+    {
+        blinkstick::simulator::unplug_all();
+        plug(1);
+        blinkstick::registry devices(blinkstick::backend::simulator);
+        const auto first = devices.get_by_path("simulator:0");
+
+        plug(1);
+        devices.refresh();
+        CHECK(devices.size() == 2);
+        CHECK(devices.get_by_path("simulator:0").get_id() == first.get_id());
+        CHECK(devices.get_by_serial("SIM1").is_valid());
+
+        blinkstick::simulator::unplug_all();
+        devices.refresh();
+        CHECK(devices.size() == 0);
+        CHECK(!devices.get_by_path("simulator:0").is_valid());
+    }
+
+    void test_add_and_remove()
+    {
+        blinkstick::simulator::unplug_all();
+        plug(1);
+        blinkstick::registry devices(blinkstick::backend::simulator);
+
+        CHECK(!devices.add(blinkstick::device_info{ "simulator:0", "OTHER", blinkstick::device_type::flex }));
+
+        // Known but not openable yet: the failed open is not cached
+        CHECK(devices.add(blinkstick::device_info{ "simulator:1", "SIM1", blinkstick::device_type::flex }));
+        CHECK(devices.size() == 2);
+        CHECK(!devices.get_by_serial("SIM1").is_valid());
+        plug(1);
+        CHECK(devices.get_by_serial("SIM1").is_valid());
+
+        const auto removed = devices.remove("simulator:0");
+        CHECK(removed.has_value());
+        if (removed)
+        {
+            CHECK(removed->serial == "SIM0");
+        }
+        CHECK(devices.size() == 1);
+        CHECK(!devices.get_by_path("simulator:0").is_valid());
+        CHECK(!devices.get_by_serial("SIM0").is_valid());
+        CHECK(!devices.remove("simulator:0").has_value());
+        CHECK(devices.get_by_serial("SIM1").is_valid());
+
+        blinkstick::simulator::unplug_all();
+    }
+}
+
+int main()
+{
+    test_lookup();
+    test_refresh_keeps_handles();
+    test_add_and_remove();
+    return check::result();
+}
@@ -0,0 +1,151 @@
+#include "check.hpp"
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/simulator.hpp>
+
+#include <chrono>
+#include <memory>
+
+namespace
+{
+    using std::chrono::steady_clock;
+
+    void test_plug_and_enumerate()
+    {
+        blinkstick::simulator::unplug_all();
+        CHECK(blinkstick::simulator::enumerate().empty());
+
+        auto flex = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 32);
+        auto pro = std::make_shared<blinkstick::simulator>(blinkstick::device_type::pro, 64);
+        blinkstick::simulator::plug(flex);
+        blinkstick::simulator::plug(pro);
+
+        const auto infos = blinkstick::simulator::enumerate();
+        CHECK(infos.size() == 2);
+        if (infos.size() == 2)
+        {
+            CHECK(infos[0].path == "simulator:0");
+            CHECK(infos[0].serial == "SIM0");
+            CHECK(infos[0].type == blinkstick::device_type::flex);
+            CHECK(infos[1].path == "simulator:1");
+            CHECK(infos[1].serial == "SIM1");
+            CHECK(infos[1].type == blinkstick::device_type::pro);
+        }
+
+        CHECK(blinkstick::simulator::open("simulator:0") == flex);
+        CHECK(blinkstick::simulator::open("simulator:1") == pro);
+        CHECK(blinkstick::simulator::open("simulator:2") == nullptr);
+        CHECK(blinkstick::simulator::open("/dev/hidraw0") == nullptr);
+
+        const auto devices = blinkstick::simulator::find_all();
+        CHECK(devices.size() == 2);
+        if (devices.size() == 2)
+        {
+            CHECK(devices[1].get_type() == blinkstick::device_type::pro);
+        }
+
+        blinkstick::simulator::unplug_all();
+        CHECK(blinkstick::simulator::enumerate().empty());
+        CHECK(blinkstick::simulator::open("simulator:0") == nullptr);
+    }
+
+    void test_led_count_report()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 20);
+        uint8_t report[2] = { 0x81, 0 };
+        CHECK(sim->get_feature_report(report, sizeof(report)));
+        CHECK(report[1] == 20);
+
+        const blinkstick::device target(sim, blinkstick::device_type::flex);
+        CHECK(target.get_led_count() == 20);
+        CHECK(target.set_led_count(40));
+        CHECK(sim->get_led_count() == 40);
+        CHECK(sim->report_count(0x81) == 3);
+
+        // Too short to carry a count
+        CHECK(!sim->send_feature_report(report, 1));
+        CHECK(sim->failure_count(0x81) == 1);
+    }
+
+    void test_reports_change_leds()
+    {
+        blinkstick::simulator sim(blinkstick::device_type::pro, 8);
+
+        const uint8_t single[] = { 5, 2, 7, 10, 20, 30 };
+        CHECK(sim.send_feature_report(single, sizeof(single)));
+        CHECK((sim.get_colour(2, 7) == blinkstick::colour{ 10, 20, 30 }));
+
+        // Bulk reports carry GRB triplets
+        uint8_t bulk[8 * 3 + 2] = { 6, 0, 1, 2, 3 };
+        CHECK(sim.send_feature_report(bulk, sizeof(bulk)));
+        CHECK((sim.get_colour(0, 0) == blinkstick::colour{ 2, 1, 3 }));
+
+        uint8_t read[8 * 3 + 2] = { 6 };
+        CHECK(sim.get_feature_report(read, sizeof(read)));
+        CHECK(read[2] == 1 && read[3] == 2 && read[4] == 3);
+
+        const uint8_t bad_channel[] = { 5, 3, 0, 1, 1, 1 };
+        CHECK(!sim.send_feature_report(bad_channel, sizeof(bad_channel)));
+        CHECK(sim.failure_count(5) == 1);
+    }
+
+    void test_latency_and_jitter()
+    {
+        blinkstick::simulator sim(blinkstick::device_type::basic, 1, 7);
+        sim.set_profile(5, blinkstick::report_profile{ std::chrono::milliseconds(3) });
+        const uint8_t report[] = { 5, 0, 0, 1, 2, 3 };
+
+        auto start = steady_clock::now();
+        CHECK(sim.send_feature_report(report, sizeof(report)));
+        CHECK(steady_clock::now() - start >= std::chrono::milliseconds(3));
+
+        // Other reports keep the default profile
+        const uint8_t mode[] = { 4, 1 };
+        start = steady_clock::now();
+        CHECK(sim.send_feature_report(mode, sizeof(mode)));
+        CHECK(steady_clock::now() - start < std::chrono::milliseconds(3));
+
+        // Twenty draws from [0, 4] ms add up to well over the 3 ms latency alone
+        sim.set_profile(5, blinkstick::report_profile{ std::chrono::nanoseconds(0), std::chrono::milliseconds(4) });
+        start = steady_clock::now();
+        for (int i = 0; i < 20; ++i)
+        {
+            sim.send_feature_report(report, sizeof(report));
+        }
+        CHECK(steady_clock::now() - start >= std::chrono::milliseconds(10));
+    }
+
+    void test_failure_rate()
+    {
+        blinkstick::simulator sim(blinkstick::device_type::basic, 1, 11);
+        const uint8_t report[] = { 1, 9, 8, 7 };
+
+        sim.set_profile(blinkstick::report_profile{ {}, {}, 1.0 });
+        CHECK(!sim.send_feature_report(report, sizeof(report)));
+        CHECK(sim.failure_count(1) == 1);
+        CHECK(sim.report_count(1) == 0);
+        CHECK(sim.get_colour(0, 0) == blinkstick::colour{});
+
+        sim.set_profile(blinkstick::report_profile{ {}, {}, 0.5 });
+        for (int i = 0; i < 1000; ++i)
+        {
+            sim.send_feature_report(report, sizeof(report));
+        }
+        CHECK(sim.failure_count(1) + sim.report_count(1) == 1001);
+        CHECK(sim.failure_count(1) > 400 && sim.failure_count(1) < 600);
+
+        sim.set_profile(blinkstick::report_profile{});
+        CHECK(sim.send_feature_report(report, sizeof(report)));
+        CHECK((sim.get_colour(0, 0) == blinkstick::colour{ 9, 8, 7 }));
+    }
+}
+
+int main()
+{
+    test_plug_and_enumerate();
+    test_led_count_report();
+    test_reports_change_leds();
+    test_latency_and_jitter();
+    test_failure_rate();
+    return check::result();
+}
@@ -0,0 +1,177 @@
+#include "check.hpp"
+#include "protocol.hpp"
+
+#include <blinkstick/device.hpp>
+#include <blinkstick/simulator.hpp>
+#include <blinkstick/stats.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    using blinkstick::latency_histogram;
+
+    void test_bucket_edges()
+    {
+        // Below 16 every nanosecond has its own bucket
+        CHECK(latency_histogram::bucket_index(0) == 0);
+        CHECK(latency_histogram::bucket_index(15) == 15);
+        CHECK(latency_histogram::bucket_upper_bound(0) == 1);
+        CHECK(latency_histogram::bucket_upper_bound(15) == 16);
+
+        // The first log-linear power of two still has a width of one
+        CHECK(latency_histogram::bucket_index(16) == 16);
+        CHECK(latency_histogram::bucket_index(31) == 31);
+        CHECK(latency_histogram::bucket_upper_bound(31) == 32);
+
+        // Every later power of two starts a new group of 16 buckets, which ends right below it
+        for (int k = 5; k <= latency_histogram::max_exponent; ++k)
+        {
+            const uint64_t power = uint64_t{ 1 } << k;
+            const auto first = static_cast<size_t>(latency_histogram::sub_bucket_count * (k - 3));
+            CHECK(latency_histogram::bucket_index(power) == first);
+            CHECK(latency_histogram::bucket_index(power - 1) == first - 1);
+            CHECK(latency_histogram::bucket_upper_bound(first - 1) == power);
+        }
+
+        // Each bucket's upper bound is the first value of the next one
+        for (size_t i = 0; i + 1 < latency_histogram::bucket_count; ++i)
+        {
+            const auto bound = latency_histogram::bucket_upper_bound(i);
+            CHECK(latency_histogram::bucket_index(bound - 1) == i);
+            CHECK(latency_histogram::bucket_index(bound) == i + 1);
+        }
+    }
+
+    void test_max_exponent_clamp()
+    {
+        const size_t last = latency_histogram::bucket_count - 1;
+        const uint64_t ceiling = uint64_t{ 1 } << (latency_histogram::max_exponent + 1);
+        CHECK(latency_histogram::bucket_upper_bound(last) == ceiling);
+        CHECK(latency_histogram::bucket_index(ceiling - 1) == last);
+        CHECK(latency_histogram::bucket_index(ceiling) == last);
+        CHECK(latency_histogram::bucket_index(uint64_t{ 1 } << 50) == last);
+        CHECK(latency_histogram::bucket_index(std::numeric_limits<uint64_t>::max()) == last);
+
+        latency_histogram histogram;
+        histogram.record(std::chrono::hours(1));
+        const auto snapshot = histogram.snapshot();
+        CHECK(snapshot.buckets.size() == latency_histogram::bucket_count);
+        CHECK(snapshot.buckets[last] == 1);
+
+        // The last bucket has no upper bound, so its samples report the maximum
+        CHECK(snapshot.percentile(1.0) == std::chrono::hours(1));
+    }
+
+    void test_percentiles()
+    {
+        latency_histogram histogram;
+        CHECK(histogram.snapshot().percentile(0.5).count() == 0);
+        CHECK(histogram.snapshot().mean().count() == 0);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            histogram.record(std::chrono::nanoseconds(5));
+        }
+        for (int i = 0; i < 89; ++i)
+        {
+            histogram.record(std::chrono::nanoseconds(1000));
+        }
+        histogram.record(std::chrono::nanoseconds(5000));
+        histogram.record(std::chrono::nanoseconds(-7));
+
+        const auto snapshot = histogram.snapshot();
+        CHECK(snapshot.count == 101);
+        CHECK(snapshot.max_ns == 5000);
+        CHECK(snapshot.buckets[0] == 1);
+        CHECK(snapshot.total_ns == 50 + 89000 + 5000);
+
+        // Results are the top of the bucket, 1000 lands in [992, 1024)
+        CHECK(snapshot.percentile(0.0).count() == 0);
+        CHECK(snapshot.percentile(0.1).count() == 5);
+        CHECK(snapshot.percentile(0.5).count() == 1023);
+        CHECK(snapshot.percentile(0.99).count() == 1023);
+
+        // 5000 lands in [4864, 5120), but a percentile is never above the maximum
+        CHECK(snapshot.percentile(1.0).count() == 5000);
+        CHECK(snapshot.percentile(2.0).count() == 5000);
+        CHECK(snapshot.mean().count() == (50 + 89000 + 5000) / 101);
+    }
+
+    void test_report_counters()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 8);
+        const blinkstick::device target(sim, blinkstick::device_type::flex);
+
+        // The mode is read once and cached from then on
+        target.get_mode();
+        CHECK(target.set_mode(blinkstick::mode::normal));
+        CHECK(target.get_mode() == blinkstick::mode::normal);
+        CHECK(target.set_colours(0, std::vector<blinkstick::colour>(8, blinkstick::colour{ 1, 2, 3 })));
+
+        const auto stats = target.get_stats();
+        CHECK(stats.reports_sent[4] == 1);
+        CHECK(stats.reports_read[4] == 1);
+        CHECK(stats.reports_sent[6] == 1);
+        // The frame needs the LED count first
+        CHECK(stats.reports_read[0x81] == 1);
+        CHECK(stats.frames == 1);
+        CHECK(stats.bytes_sent == blinkstick::protocol::MODE_MSG_SIZE + 2 + 8 * 3);
+        CHECK(stats.bytes_read == blinkstick::protocol::MODE_MSG_SIZE + blinkstick::protocol::COUNT_MSG_SIZE);
+        CHECK(stats.errors == 0);
+        CHECK(stats.retries == 0);
+        CHECK(stats.send_latency.count == 2);
+        CHECK(stats.get_latency.count == 2);
+    }
+
+    void test_retry_limit()
+    {
+        auto sim = std::make_shared<blinkstick::simulator>(blinkstick::device_type::flex, 8);
+        sim->set_profile(4, blinkstick::report_profile{ {}, {}, 1.0 });
+        blinkstick::device target(sim, blinkstick::device_type::flex);
+
+        // No retries by default
+        CHECK(!target.set_mode(blinkstick::mode::inverse));
+        CHECK(target.get_stats().errors == 1);
+        CHECK(target.get_stats().retries == 0);
+
+        target.set_retry_limit(2);
+        CHECK(!target.set_mode(blinkstick::mode::inverse));
+        auto stats = target.get_stats();
+        CHECK(stats.errors == 4);
+        CHECK(stats.retries == 2);
+        CHECK(stats.reports_sent[4] == 0);
+        CHECK(stats.send_latency.count == 4);
+        CHECK(sim->failure_count(4) == 4);
+
+        // Negative limits mean no retries
+        target.set_retry_limit(-3);
+        CHECK(!target.set_mode(blinkstick::mode::inverse));
+        stats = target.get_stats();
+        CHECK(stats.errors == 5);
+        CHECK(stats.retries == 2);
+
+        // Retries stop at the first success
+        sim->set_profile(4, blinkstick::report_profile{ {}, {}, 0.0 });
+        target.set_retry_limit(2);
+        CHECK(target.set_mode(blinkstick::mode::inverse));
+        stats = target.get_stats();
+        CHECK(stats.errors == 5);
+        CHECK(stats.retries == 2);
+        CHECK(stats.reports_sent[4] == 1);
+    }
+}
+
+int main()
+{
+    test_bucket_edges();
+    test_max_exponent_clamp();
+    test_percentiles();
+    test_report_counters();
+    test_retry_limit();
+    return check::result();
+}
@@ -0,0 +1,168 @@
+#include "check.hpp"
+
+#include <blinkstick/transport.hpp>
+#include <blinkstick/variant.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    using blinkstick::colour;
+
+    // Layouts are compile-time constants
+    static_assert(blinkstick::basic_device::led_count == 1 && blinkstick::basic_device::channels == 1);
+    static_assert(blinkstick::basic_device::segments == 1);
+
+    static_assert(blinkstick::strip_device::led_count == 8 && blinkstick::strip_device::channels == 1);
+    static_assert(blinkstick::strip_device::layout.report_id == 6 && blinkstick::strip_device::layout.size == 8 * 3 + 2);
+
+    static_assert(blinkstick::flex_device<>::led_count == 32 && blinkstick::flex_device<>::segments == 1);
+    static_assert(blinkstick::flex_device<>::layout.report_id == 8 && blinkstick::flex_device<>::layout.size == 32 * 3 + 2);
+    static_assert(blinkstick::flex_device<20>::layout.report_id == 8 && blinkstick::flex_device<20>::layout.max_leds == 32);
+    static_assert(blinkstick::flex_device<9>::layout.report_id == 7);
+    static_assert(blinkstick::flex_device<64>::layout.report_id == 9 && blinkstick::flex_device<64>::segments == 1);
+
+    static_assert(blinkstick::pro_device<>::led_count == 64 && blinkstick::pro_device<>::channels == 3);
+    static_assert(blinkstick::pro_device<>::segments == 1 && blinkstick::pro_device<>::layout.report_id == 9);
+    static_assert(blinkstick::pro_device<100>::segments == 2);
+    static_assert(blinkstick::pro_device<100>::layout.report_id == 9 && blinkstick::pro_device<100>::last_layout.report_id == 9);
+    static_assert(blinkstick::pro_device<130>::segments == 3 && blinkstick::pro_device<130>::last_layout.report_id == 6);
+    static_assert(blinkstick::pro_device<192>::segments == 3 && blinkstick::pro_device<192>::last_layout.report_id == 9);
+
+    // Keeps a copy of every report sent
+    class recording : public blinkstick::transport
+    {
+    public:
+        bool send_feature_report(const uint8_t* data, const size_t size) override
+        {
+            reports.emplace_back(data, data + size);
+            return true;
+        }
+
+        bool get_feature_report(uint8_t*, size_t) override
+        {
+            ++reads;
+            return true;
+        }
+
+        std::vector<std::vector<uint8_t>> reports;
+        int reads = 0;
+    };
+
+    template<typename Frame>
+    Frame numbered()
+    {
+        Frame colours{};
+        for (size_t i = 0; i < colours.size(); ++i)
+        {
+            colours[i] = colour{ static_cast<uint8_t>(i), static_cast<uint8_t>(i + 100), static_cast<uint8_t>(i * 2) };
+        }
+        return colours;
+    }
+
+    // The bulk report for LEDs [first, first + count) of colours, padded to report_leds
+    template<typename Frame>
+    std::vector<uint8_t> bulk(const uint8_t report_id, const int channel, const Frame& colours, const int first, const int count, const int report_leds)
+    {
+        std::vector<uint8_t> report = { report_id, static_cast<uint8_t>(channel) };
+        for (int i = 0; i < report_leds; ++i)
+        {
+            const colour value = i < count ? colours[first + i] : colour{};
+            report.push_back(value.green);
+            report.push_back(value.red);
+            report.push_back(value.blue);
+        }
+        return report;
+    }
+
+    template<blinkstick::device_type Type, int LedCount, int Channel = 0>
+    std::vector<std::vector<uint8_t>> send(const typename blinkstick::fixed_device<Type, LedCount>::frame& colours)
+    {
+        auto io = std::make_shared<recording>();
+        const blinkstick::fixed_device<Type, LedCount> target(blinkstick::device(io, Type));
+        CHECK(target.is_valid());
+        CHECK(target.template set_colours<Channel>(colours));
+
+        // Nothing is looked up on the device first
+        CHECK(io->reads == 0);
+        return io->reports;
+    }
+
+    void test_basic()
+    {
+        const blinkstick::basic_device::frame colours = { colour{ 10, 20, 30 } };
+        const auto reports = send<blinkstick::device_type::basic, 1>(colours);
+        CHECK(reports == (std::vector<std::vector<uint8_t>>{ { 1, 10, 20, 30 } }));
+    }
+
+    void test_strip()
+    {
+        const auto colours = numbered<blinkstick::strip_device::frame>();
+        const auto reports = send<blinkstick::device_type::strip, 8>(colours);
+        CHECK(reports == (std::vector<std::vector<uint8_t>>{ bulk(6, 0, colours, 0, 8, 8) }));
+    }
+
+    void test_flex()
+    {
+        const auto full = numbered<blinkstick::flex_device<>::frame>();
+        CHECK((send<blinkstick::device_type::flex, 32>(full) == (std::vector<std::vector<uint8_t>>{ bulk(8, 0, full, 0, 32, 32) })));
+
+        // LEDs the report has room for beyond the count are turned off
+        const auto partial = numbered<blinkstick::flex_device<20>::frame>();
+        CHECK((send<blinkstick::device_type::flex, 20>(partial) == (std::vector<std::vector<uint8_t>>{ bulk(8, 0, partial, 0, 20, 32) })));
+
+        const auto largest = numbered<blinkstick::flex_device<64>::frame>();
+        CHECK((send<blinkstick::device_type::flex, 64>(largest) == (std::vector<std::vector<uint8_t>>{ bulk(9, 0, largest, 0, 64, 64) })));
+    }
+
+    void test_pro()
+    {
+        const auto one = numbered<blinkstick::pro_device<>::frame>();
+        CHECK((send<blinkstick::device_type::pro, 64, 2>(one) == std::vector<std::vector<uint8_t>>{ bulk(9, 2, one, 0, 64, 64) }));
+
+        // Longer strips run on across consecutive channels, starting from the one given
+        const auto two = numbered<blinkstick::pro_device<100>::frame>();
+        CHECK((send<blinkstick::device_type::pro, 100, 1>(two)
+            == std::vector<std::vector<uint8_t>>{ bulk(9, 1, two, 0, 64, 64), bulk(9, 2, two, 64, 36, 64) }));
+
+        const auto three = numbered<blinkstick::pro_device<130>::frame>();
+        CHECK((send<blinkstick::device_type::pro, 130>(three)
+            == std::vector<std::vector<uint8_t>>{ bulk(9, 0, three, 0, 64, 64), bulk(9, 1, three, 64, 64, 64), bulk(6, 2, three, 128, 2, 8) }));
+
+        const auto all = numbered<blinkstick::pro_device<192>::frame>();
+        CHECK((send<blinkstick::device_type::pro, 192>(all)
+            == std::vector<std::vector<uint8_t>>{ bulk(9, 0, all, 0, 64, 64), bulk(9, 1, all, 64, 64, 64), bulk(9, 2, all, 128, 64, 64) }));
+    }
+
+    void test_brightness_and_validity()
+    {
+        auto io = std::make_shared<recording>();
+        blinkstick::device inner(io, blinkstick::device_type::strip);
+        inner.set_brightness(127);
+        const blinkstick::strip_device target(inner);
+
+        blinkstick::strip_device::frame colours{};
+        colours.fill(colour{ 200, 100, 50 });
+        CHECK(target.set_colours(colours));
+        CHECK(io->reports.size() == 1);
+        CHECK(io->reports[0][2] == 50);
+        CHECK(io->reports[0][3] == 100);
+        CHECK(io->reports[0][4] == 25);
+
+        // The wrapped device must be of the right model
+        CHECK(!blinkstick::flex_device<>(blinkstick::device(io, blinkstick::device_type::pro)).is_valid());
+        CHECK(!blinkstick::strip_device(blinkstick::device(nullptr, blinkstick::device_type::strip)).is_valid());
+    }
+}
+
+int main()
+{
+    test_basic();
+    test_strip();
+    test_flex();
+    test_pro();
+    test_brightness_and_validity();
+    return check::result();
+}